@@ -35,13 +35,13 @@ class BaseVertex
 public:
 	int 	getID() const 								{ return mID; }
 	void 	setID(int ID_)								{ mID = ID_; }
-	double 	Weight() const 								{ return mWeight; }
-	void 	Weight(double val) 							{ mWeight = val; }
+	int 	getIndex() const 							{ return mIndex; }
+	void 	setIndex(int index_)						{ mIndex = index_; }
 	void 	printOut(std::ostream &out_stream) 			{ out_stream << mID; }
 
 private:
 	int 		mID;
-	double 		mWeight;
+	int 		mIndex; // dense position in the graph storage
 };
 
 class BasePath
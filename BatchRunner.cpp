@@ -0,0 +1,290 @@
+#include <set>
+#include <map>
+#include <deque>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "GraphImage.h"
+#include "LineSocket.h"
+#include "QueryServer.h"
+#include "BatchRunner.h"
+
+/* Period of the timeout checks while no answer comes */
+static const int POLL_PERIOD_MS = 100;
+
+BatchRunner::BatchRunner(const GraphImage &image, int process_num, int chunk_size, double timeout_s, int max_attempts, int max_k, int max_flow_limit)
+	: mImage(image), mChunkSize(std::max(1, chunk_size)), mTimeout(timeout_s), mMaxAttempts(std::max(1, max_attempts)),
+	  mMaxK(max_k), mMaxFlowLimit(max_flow_limit), mpRequests(NULL), mpOut(NULL)
+{
+	Worker worker = {-1, NULL, std::deque<long long>(), std::chrono::steady_clock::now()};
+	mvWorkers.assign(std::max(1, process_num), worker);
+}
+
+BatchRunner::~BatchRunner(void)
+{
+	for (size_t slot = 0; slot < mvWorkers.size(); ++slot)
+	{
+		stopWorker(slot);
+	}
+}
+
+/* Resident memory of a process from /proc, in kB: the anonymous pages are its own, the file pages are mostly the image */
+static long long residentKb(int pid, const std::string &field)
+{
+	std::ifstream ifs(("/proc/" + std::to_string(pid) + "/status").c_str());
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (line.compare(0, field.size(), field) == 0)
+		{
+			return atoll(line.c_str() + field.size());
+		}
+	}
+	return 0;
+}
+
+void BatchRunner::run(const std::vector<std::string> &requests, std::ostream &out)
+{
+	mpRequests = &requests;
+	mpOut = &out;
+	mqWaiting.clear();
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		mqWaiting.push_back(i);
+	}
+	mvAttempts.assign(requests.size(), 0);
+	mmAnswers.clear();
+	mNextAnswer = 0;
+	mCrashesSinceAnswer = 0;
+	mRestartNum = 0;
+	mFailedRequestNum = 0;
+	mErrorAnswerNum = 0;
+	mAnswerDigest = 0;
+	mWorkerPrivateKb = 0;
+	mWorkerMappedKb = 0;
+	for (size_t slot = 0; slot < mvWorkers.size(); ++slot)
+	{
+		if (mvWorkers[slot].socket == NULL)
+		{
+			startWorker(slot);
+		}
+	}
+
+	while (mNextAnswer < (long long)requests.size())
+	{
+		std::vector<pollfd> poll_fds;
+		for (size_t slot = 0; slot < mvWorkers.size(); ++slot)
+		{
+			dispatch(slot);
+			pollfd poll_fd = {mvWorkers[slot].socket->getFd(), POLLIN, 0};
+			poll_fds.push_back(poll_fd);
+		}
+		if (poll(poll_fds.data(), poll_fds.size(), mTimeout > 0 ? POLL_PERIOD_MS : -1) < 0 && errno != EINTR)
+		{
+			std::cerr << "The workers can not be polled." << std::endl;
+			exit(1);
+		}
+		for (size_t slot = 0; slot < poll_fds.size(); ++slot)
+		{
+			if (poll_fds[slot].revents != 0)
+			{
+				readAnswers(slot);
+			}
+		}
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		for (size_t slot = 0; slot < mvWorkers.size() && mTimeout > 0; ++slot)
+		{
+			if (!mvWorkers[slot].in_flight.empty() && std::chrono::duration<double>(now - mvWorkers[slot].busy_since).count() > mTimeout)
+			{
+				restartWorker(slot, "timed out");
+			}
+		}
+		writeAnswers();
+	}
+
+	for (size_t slot = 0; slot < mvWorkers.size(); ++slot)
+	{
+		mWorkerPrivateKb = std::max(mWorkerPrivateKb, residentKb(mvWorkers[slot].pid, "RssAnon:"));
+		mWorkerMappedKb = std::max(mWorkerMappedKb, residentKb(mvWorkers[slot].pid, "RssFile:"));
+	}
+	out.flush();
+}
+
+/* Fork a worker connected by a socket pair. The child answers from a graph on the image mapped by the parent,
+and leaves with _exit so that it never flushes the output buffers inherited from the parent. */
+void BatchRunner::startWorker(int slot)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		std::cerr << "The socket of a worker can not be created." << std::endl;
+		exit(1);
+	}
+	mpOut->flush();
+	fflush(NULL);
+	int pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "The worker process can not be forked." << std::endl;
+		exit(1);
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		for (size_t i = 0; i < mvWorkers.size(); ++i)
+		{
+			if (mvWorkers[i].socket != NULL)
+			{
+				close(mvWorkers[i].socket->getFd());
+			}
+		}
+		serveWorker(fds[1]);
+		_exit(0);
+	}
+	close(fds[1]);
+	Worker &worker = mvWorkers[slot];
+	worker.pid = pid;
+	worker.socket = new LineSocket(fds[0]);
+	worker.in_flight.clear();
+}
+
+/* Worker side: one "<request_id> <request>" line in, one answer line out, in order */
+void BatchRunner::serveWorker(int fd)
+{
+	Graph graph(mImage);
+	QueryServer server(graph, 1, 1, mMaxK, mMaxFlowLimit);
+	LineSocket socket(fd);
+	std::string line;
+	while (socket.readLine(line))
+	{
+		size_t space_pos = line.find(' ');
+		long long request_id = atoll(line.substr(0, space_pos).c_str());
+		std::string request = space_pos == std::string::npos ? std::string() : line.substr(space_pos + 1);
+		if (!socket.writeAll(server.answer(request, request_id) + "\n"))
+		{
+			return;
+		}
+	}
+}
+
+void BatchRunner::dispatch(int slot)
+{
+	Worker &worker = mvWorkers[slot];
+	if (worker.in_flight.empty())
+	{
+		worker.busy_since = std::chrono::steady_clock::now();
+	}
+	std::string lines;
+	while ((int)worker.in_flight.size() < mChunkSize && !mqWaiting.empty())
+	{
+		long long request_id = mqWaiting.front();
+		mqWaiting.pop_front();
+		worker.in_flight.push_back(request_id);
+		lines += std::to_string(request_id) + " " + (*mpRequests)[request_id] + "\n";
+	}
+	// a worker gone meanwhile shows up as the end of its stream
+	if (!lines.empty())
+	{
+		worker.socket->writeAll(lines);
+	}
+}
+
+void BatchRunner::readAnswers(int slot)
+{
+	Worker &worker = mvWorkers[slot];
+	do
+	{
+		std::string line;
+		// an answer cut by the end of the worker is not one: every answer is a whole JSON object
+		if (!worker.socket->readLine(line) || line.empty() || line[line.size() - 1] != '}' || worker.in_flight.empty())
+		{
+			restartWorker(slot, "died");
+			return;
+		}
+		mmAnswers[worker.in_flight.front()] = line;
+		worker.in_flight.pop_front();
+		worker.busy_since = std::chrono::steady_clock::now();
+		mCrashesSinceAnswer = 0;
+	} while (worker.socket->hasBufferedLine());
+}
+
+/* Kill and replace a worker. The requests in flight go back first in the queue,
+the one it was answering (the first one, as a worker answers in order) with one more attempt. */
+void BatchRunner::restartWorker(int slot, const std::string &reason)
+{
+	Worker &worker = mvWorkers[slot];
+	int pid = worker.pid;
+	stopWorker(slot);
+	std::cerr << "[BATCH] worker " << pid << " " << reason;
+	if (!worker.in_flight.empty())
+	{
+		long long request_id = worker.in_flight.front();
+		worker.in_flight.pop_front();
+		std::cerr << " on request " << request_id;
+		if (++mvAttempts[request_id] >= mMaxAttempts)
+		{
+			mmAnswers[request_id] = QueryServer::errorAnswer(request_id, "the worker " + reason + " " + std::to_string(mMaxAttempts) + " times");
+			++mFailedRequestNum;
+			mCrashesSinceAnswer = 0;
+		}
+		else
+		{
+			worker.in_flight.push_front(request_id);
+		}
+	}
+	std::cerr << ", restarted" << std::endl;
+	mqWaiting.insert(mqWaiting.begin(), worker.in_flight.begin(), worker.in_flight.end());
+	worker.in_flight.clear();
+
+	// workers dying without any answer, even a failed one, in between: they can not even start
+	if (++mCrashesSinceAnswer > (int)mvWorkers.size() * mMaxAttempts)
+	{
+		std::cerr << "The workers keep dying, the batch is given up." << std::endl;
+		exit(1);
+	}
+	++mRestartNum;
+	startWorker(slot);
+}
+
+/* Close the socket of a worker, which ends it; one still busy is killed */
+void BatchRunner::stopWorker(int slot)
+{
+	Worker &worker = mvWorkers[slot];
+	if (worker.socket == NULL)
+	{
+		return;
+	}
+	if (!worker.in_flight.empty())
+	{
+		kill(worker.pid, SIGKILL);
+	}
+	delete worker.socket;
+	worker.socket = NULL;
+	int status = 0;
+	waitpid(worker.pid, &status, 0);
+}
+
+void BatchRunner::writeAnswers()
+{
+	std::hash<std::string> hash;
+	for (std::map<long long, std::string>::iterator pos = mmAnswers.begin(); pos != mmAnswers.end() && pos->first == mNextAnswer; pos = mmAnswers.erase(pos))
+	{
+		*mpOut << pos->second << '\n';
+		mAnswerDigest = mAnswerDigest * 1000003 ^ hash(pos->second);
+		mErrorAnswerNum += pos->second.find("\"error\":") != std::string::npos ? 1 : 0;
+		++mNextAnswer;
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef __BATCHRUNNER_H__
+#define __BATCHRUNNER_H__
+
+class LineSocket;
+
+/* Coordinator of a batch of requests answered by forked worker processes, all reading one mapped GraphImage (POSIX only).
+The requests are the lines of the query server, each worker answers them with a QueryServer on a Graph built on the
+image, so that the edge arrays are in memory once whatever the number of processes.
+A worker has up to chunk_size requests in flight at a time: the faster ones take more of the batch. The answers are
+written in the order of the requests, each one as soon as the ones before it are there.
+A worker that dies, or that spends more than the timeout on one request, is killed and replaced. Its requests in flight
+are sent again, the one it was answering counting as a failed attempt: after max_attempts, the request is answered
+with an error instead, so that one bad request does not stop the batch. */
+class BatchRunner
+{
+public:
+	BatchRunner(const GraphImage &image, int process_num, int chunk_size, double timeout_s, int max_attempts, int max_k, int max_flow_limit);
+	~BatchRunner(void);
+
+	/* Answer every request (request_id = position in the list), one line each to out */
+	void 			run(const std::vector<std::string> &requests, std::ostream &out);
+
+	/* Workers restarted, requests given up after max_attempts and answers with an error, during the last run */
+	int 			getRestartNum() const 				{ return mRestartNum; }
+	int 			getFailedRequestNum() const 		{ return mFailedRequestNum; }
+	int 			getErrorAnswerNum() const 			{ return mErrorAnswerNum; }
+	/* Hash of the answers in order, to compare runs */
+	size_t 			getAnswerDigest() const 			{ return mAnswerDigest; }
+	/* Largest private and file-backed resident memory of a worker at the end of the last run, 0 if unknown */
+	long long 		getWorkerPrivateKb() const 			{ return mWorkerPrivateKb; }
+	long long 		getWorkerMappedKb() const 			{ return mWorkerMappedKb; }
+
+protected:
+	void 			startWorker(int slot);
+	void 			serveWorker(int fd);
+	void 			dispatch(int slot);
+	void 			readAnswers(int slot);
+	void 			restartWorker(int slot, const std::string &reason);
+	void 			stopWorker(int slot);
+	void 			writeAnswers();
+
+private:
+	struct Worker
+	{
+		int 									pid;
+		LineSocket* 							socket;
+		std::deque<long long> 					in_flight;
+		std::chrono::steady_clock::time_point 	busy_since;
+	};
+
+	const GraphImage& 							mImage;
+	int 										mChunkSize;
+	double 										mTimeout;
+	int 										mMaxAttempts;
+	int 										mMaxK;
+	int 										mMaxFlowLimit;
+	std::vector<Worker> 						mvWorkers;
+
+	const std::vector<std::string>* 			mpRequests;
+	std::ostream* 								mpOut;
+	std::deque<long long> 						mqWaiting;
+	std::vector<int> 							mvAttempts;
+	std::map<long long, std::string> 			mmAnswers;
+	long long 									mNextAnswer;
+	int 										mCrashesSinceAnswer;
+
+	int 										mRestartNum;
+	int 										mFailedRequestNum;
+	int 										mErrorAnswerNum;
+	size_t 										mAnswerDigest;
+	long long 									mWorkerPrivateKb;
+	long long 									mWorkerMappedKb;
+};
+
+#endif // __BATCHRUNNER_H__
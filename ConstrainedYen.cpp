@@ -0,0 +1,428 @@
+#include <set>
+#include <map>
+#include <deque>
+#include <queue>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "FlatGraph.h"
+#include "PathConstraints.h"
+#include "ConstrainedYen.h"
+
+/* Hop bound of the vertices not reaching an anchor, small enough not to overflow when hops are added */
+static const int UNREACHABLE_HOPS = INT_MAX / 4;
+
+ConstrainedYen::ConstrainedYen(Graph &graph, const PathConstraints &constraints, BaseVertex *pSource, BaseVertex *pTarget)
+	: mFlatGraph(graph), mConstraints(constraints), mpSourceVertex(pSource), mpTargetVertex(pTarget), mRemainingPathNum(-1), mStamp(0)
+{
+	// the constraints by node ID, turned into flags over the snapshot
+	int vertex_num = mFlatGraph.getVertexNum();
+	mvIsForbiddenVertex.assign(vertex_num, 0);
+	mvIsForbiddenEdge.assign(mFlatGraph.getEdgeNum(), 0);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		int node_id = mFlatGraph.getVertex(v)->getID();
+		mvIsForbiddenVertex[v] = constraints.isForbiddenVertex(node_id);
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			mvIsForbiddenEdge[e] = constraints.isForbiddenEdge(node_id, mFlatGraph.getVertex(mFlatGraph.outTarget(e))->getID());
+		}
+	}
+	// a via point missing from the graph keeps the index -1: no path meets the constraints
+	for (size_t i = 0; i < constraints.getViaIds().size(); ++i)
+	{
+		mvViaIndices.push_back(graph.getInternalIndex(constraints.getViaIds()[i]));
+	}
+	mStageNum = mvViaIndices.size();
+	mvStateStamp.assign((size_t)vertex_num * (mStageNum + 1), 0);
+	mvSettledHops.assign(mvStateStamp.size(), 0);
+	mvBlockedStamp.assign(mvStateStamp.size(), 0);
+	initialize();
+}
+
+ConstrainedYen::~ConstrainedYen(void)
+{
+	clear();
+}
+
+/* The paths returned so far are deleted as well */
+void ConstrainedYen::clear()
+{
+	mGeneratedPathNum = 0;
+	mSpurSearchNum = 0;
+	mPrunedSpurNum = 0;
+	mRemainingPathNum = -1;
+	mmDeviationIndex.clear();
+	msKnownPaths.clear();
+	mvResultIndices.clear();
+	for_each(mvResultList.begin(), mvResultList.end(), DeleteFunc<BasePath>());
+	mvResultList.clear();
+	for_each(mqPathCandidates.begin(), mqPathCandidates.end(), DeleteFunc<BasePath>());
+	mqPathCandidates.clear();
+}
+
+void ConstrainedYen::initialize()
+{
+	clear();
+	if (mpSourceVertex == NULL || mpTargetVertex == NULL || mpSourceVertex == mpTargetVertex)
+	{
+		return;
+	}
+	computeBounds();
+	int source = mpSourceVertex->getIndex();
+	std::vector<int> shortest_path;
+	double cost;
+	++mStamp;
+	if (searchSpur(source, advanceStage(source, 0), mConstraints.getMaxHopNum(), mConstraints.getMaxCost(), std::vector<int>(), shortest_path, cost))
+	{
+		BasePath *pShortestPath = makePath(shortest_path, cost);
+		mqPathCandidates.insert(pShortestPath);
+		mmDeviationIndex[pShortestPath] = 0;
+		msKnownPaths.insert(shortest_path);
+	}
+}
+
+/* Reverse searches from every anchor, i.e. the via points and the target, avoiding the forbidden vertices and edges:
+the least cost and the least hops from a vertex to each anchor, and along the chain of the anchors after it. */
+void ConstrainedYen::computeBounds()
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	bool has_hop_limit = mConstraints.getMaxHopNum() >= 0;
+	mvCostToAnchor.assign(mStageNum + 1, std::vector<double>(vertex_num, Graph::DISCONNECT));
+	mvHopsToAnchor.assign(has_hop_limit ? mStageNum + 1 : 0, std::vector<int>(vertex_num, UNREACHABLE_HOPS));
+
+	// the fan-in edges are not numbered as the fan-out ones: look the forbidden ones up by their end
+	std::vector<std::vector<int>> forbidden_preds(vertex_num);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			if (mvIsForbiddenEdge[e])
+			{
+				forbidden_preds[mFlatGraph.outTarget(e)].push_back(v);
+			}
+		}
+	}
+
+	for (int anchor_num = 0; anchor_num <= mStageNum; ++anchor_num)
+	{
+		int anchor = anchor_num < mStageNum ? mvViaIndices[anchor_num] : mpTargetVertex->getIndex();
+		if (anchor < 0 || mvIsForbiddenVertex[anchor])
+		{
+			continue;
+		}
+
+		std::vector<double> &cost_to = mvCostToAnchor[anchor_num];
+		std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>> candidates;
+		cost_to[anchor] = 0;
+		candidates.push(std::make_pair(0.0, anchor));
+		while (!candidates.empty())
+		{
+			std::pair<double, int> top = candidates.top();
+			candidates.pop();
+			int v = top.second;
+			if (top.first > cost_to[v])
+			{
+				continue;
+			}
+			for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+			{
+				int u = mFlatGraph.inSource(e);
+				double cost = top.first + mFlatGraph.inWeight(e);
+				if (mvIsForbiddenVertex[u] || cost >= cost_to[u] ||
+					std::find(forbidden_preds[v].begin(), forbidden_preds[v].end(), u) != forbidden_preds[v].end())
+				{
+					continue;
+				}
+				cost_to[u] = cost;
+				candidates.push(std::make_pair(cost, u));
+			}
+		}
+
+		if (!has_hop_limit)
+		{
+			continue;
+		}
+		std::vector<int> &hops_to = mvHopsToAnchor[anchor_num];
+		std::deque<int> frontier;
+		hops_to[anchor] = 0;
+		frontier.push_back(anchor);
+		while (!frontier.empty())
+		{
+			int v = frontier.front();
+			frontier.pop_front();
+			for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+			{
+				int u = mFlatGraph.inSource(e);
+				if (mvIsForbiddenVertex[u] || hops_to[u] != UNREACHABLE_HOPS ||
+					std::find(forbidden_preds[v].begin(), forbidden_preds[v].end(), u) != forbidden_preds[v].end())
+				{
+					continue;
+				}
+				hops_to[u] = hops_to[v] + 1;
+				frontier.push_back(u);
+			}
+		}
+	}
+
+	// from the via point of a stage to the target, through the via points after it
+	mvChainCost.assign(mStageNum + 1, 0);
+	mvChainHops.assign(mStageNum + 1, 0);
+	for (int stage = mStageNum - 1; stage >= 0; --stage)
+	{
+		int via = mvViaIndices[stage];
+		double cost = via < 0 ? Graph::DISCONNECT : mvCostToAnchor[stage + 1][via];
+		mvChainCost[stage] = cost < Graph::DISCONNECT && mvChainCost[stage + 1] < Graph::DISCONNECT ? cost + mvChainCost[stage + 1] : Graph::DISCONNECT;
+		if (has_hop_limit)
+		{
+			mvChainHops[stage] = via < 0 ? UNREACHABLE_HOPS : std::min(UNREACHABLE_HOPS, mvHopsToAnchor[stage + 1][via] + mvChainHops[stage + 1]);
+		}
+	}
+}
+
+/* Stage of a path entering the vertex: the number of via points passed */
+int ConstrainedYen::advanceStage(int vertex, int stage) const
+{
+	while (stage < mStageNum && mvViaIndices[stage] == vertex)
+	{
+		++stage;
+	}
+	return stage;
+}
+
+double ConstrainedYen::costBound(int vertex, int stage) const
+{
+	double cost = mvCostToAnchor[stage][vertex];
+	return cost < Graph::DISCONNECT && mvChainCost[stage] < Graph::DISCONNECT ? cost + mvChainCost[stage] : Graph::DISCONNECT;
+}
+
+int ConstrainedYen::hopBound(int vertex, int stage) const
+{
+	return std::min(UNREACHABLE_HOPS, mvHopsToAnchor[stage][vertex] + mvChainHops[stage]);
+}
+
+/* Least cost path from the spur vertex to the target with at most hop_budget edges (none if negative)
+and a cost up to cost_budget, passing the via points left after the given stage. The first edge may not lead
+to a blocked successor, the states marked with the current stamp in mvBlockedStamp are not entered.
+A state is skipped once settled with fewer hops: settled before, it costs less as well. */
+bool ConstrainedYen::searchSpur(int spur, int stage, int hop_budget, double cost_budget, const std::vector<int> &blocked_successors,
+								std::vector<int> &spur_path, double &spur_cost)
+{
+	int target = mpTargetVertex->getIndex();
+	bool has_hop_limit = hop_budget >= 0;
+	double cost_limit = cost_budget < Graph::DISCONNECT ? cost_budget + 1e-9 * (1 + std::abs(cost_budget)) : Graph::DISCONNECT;
+	double bound = costBound(spur, stage);
+	if (mvIsForbiddenVertex[spur] || bound >= Graph::DISCONNECT || bound > cost_limit || (has_hop_limit && hopBound(spur, stage) > hop_budget))
+	{
+		++mPrunedSpurNum;
+		return false;
+	}
+
+	// labels ordered by cost, then by hops
+	typedef std::pair<std::pair<double, int>, int> QueueEntry;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> candidates;
+	Label start = {spur, stage, 0, 0, -1};
+	mvLabels.clear();
+	mvLabels.push_back(start);
+	candidates.push(std::make_pair(std::make_pair(0.0, 0), 0));
+	while (!candidates.empty())
+	{
+		int label_index = candidates.top().second;
+		candidates.pop();
+		Label cur = mvLabels[label_index];
+		size_t state = (size_t)cur.vertex * (mStageNum + 1) + cur.stage;
+		if (mvStateStamp[state] == mStamp && (!has_hop_limit || mvSettledHops[state] <= cur.hops))
+		{
+			continue;
+		}
+		mvStateStamp[state] = mStamp;
+		mvSettledHops[state] = cur.hops;
+
+		if (cur.vertex == target)
+		{
+			spur_cost = cur.cost;
+			spur_path.clear();
+			for (int i = label_index; i >= 0; i = mvLabels[i].parent)
+			{
+				spur_path.push_back(mvLabels[i].vertex);
+			}
+			std::reverse(spur_path.begin(), spur_path.end());
+			return true;
+		}
+
+		for (int e = mFlatGraph.outBegin(cur.vertex); e < mFlatGraph.outEnd(cur.vertex); ++e)
+		{
+			int u = mFlatGraph.outTarget(e);
+			if (mvIsForbiddenVertex[u] || mvIsForbiddenEdge[e] ||
+				(label_index == 0 && std::find(blocked_successors.begin(), blocked_successors.end(), u) != blocked_successors.end()))
+			{
+				continue;
+			}
+			int next_stage = advanceStage(u, cur.stage);
+			size_t next_state = (size_t)u * (mStageNum + 1) + next_stage;
+			int hops = cur.hops + 1;
+			if (mvBlockedStamp[next_state] == mStamp || (mvStateStamp[next_state] == mStamp && (!has_hop_limit || mvSettledHops[next_state] <= hops)))
+			{
+				continue;
+			}
+			// the target ends a path: reached before the last via point, it is a dead end
+			double cost = cur.cost + mFlatGraph.outWeight(e);
+			bound = u == target && next_stage < mStageNum ? Graph::DISCONNECT : costBound(u, next_stage);
+			if (bound >= Graph::DISCONNECT || cost + bound > cost_limit || (has_hop_limit && hops + hopBound(u, next_stage) > hop_budget))
+			{
+				continue;
+			}
+			Label label = {u, next_stage, hops, cost, label_index};
+			mvLabels.push_back(label);
+			candidates.push(std::make_pair(std::make_pair(cost, hops), (int)mvLabels.size() - 1));
+		}
+		if (label_index == 0)
+		{
+			// no successor of the spur vertex can lead to the target within the budgets
+			if (candidates.empty())
+			{
+				++mPrunedSpurNum;
+				return false;
+			}
+			++mSpurSearchNum;
+		}
+	}
+	return false;
+}
+
+BasePath *ConstrainedYen::makePath(const std::vector<int> &path, double cost) const
+{
+	std::vector<BaseVertex *> vertex_list;
+	for (size_t i = 0; i < path.size(); ++i)
+	{
+		vertex_list.push_back(mFlatGraph.getVertex(path[i]));
+	}
+	return new Path(vertex_list, cost);
+}
+
+bool ConstrainedYen::hasNext()
+{
+	return !mqPathCandidates.empty();
+}
+
+BasePath *ConstrainedYen::next()
+{
+	BasePath *cur_path = *(mqPathCandidates.begin());
+	mqPathCandidates.erase(mqPathCandidates.begin());
+	mvResultList.push_back(cur_path);
+	int deviation_index = mmDeviationIndex.find(cur_path)->second;
+	int path_length = cur_path->length();
+	std::vector<int> cur_indices(path_length);
+	for (int i = 0; i < path_length; ++i)
+	{
+		cur_indices[i] = cur_path->getVertex(i)->getIndex();
+	}
+	mvResultIndices.push_back(cur_indices);
+
+	// with k known, the candidates beyond the paths still to return are of no use
+	double max_cost = mConstraints.getMaxCost();
+	if (mRemainingPathNum > 0 && --mRemainingPathNum == 0)
+	{
+		return cur_path;
+	}
+	if (mRemainingPathNum > 0 && (int)mqPathCandidates.size() >= mRemainingPathNum)
+	{
+		std::multiset<BasePath *, WeightLess<BasePath>>::const_iterator pos = mqPathCandidates.begin();
+		std::advance(pos, mRemainingPathNum - 1);
+		max_cost = std::min(max_cost, (*pos)->Weight());
+	}
+
+	// stage and cost of the path at each of its vertices
+	std::vector<int> stages(path_length);
+	std::vector<double> costs(path_length, 0);
+	stages[0] = advanceStage(cur_indices[0], 0);
+	for (int i = 1; i < path_length; ++i)
+	{
+		stages[i] = advanceStage(cur_indices[i], stages[i - 1]);
+		for (int e = mFlatGraph.outBegin(cur_indices[i - 1]); e < mFlatGraph.outEnd(cur_indices[i - 1]); ++e)
+		{
+			if (mFlatGraph.outTarget(e) == cur_indices[i])
+			{
+				costs[i] = costs[i - 1] + mFlatGraph.outWeight(e);
+				break;
+			}
+		}
+	}
+
+	int max_hop_num = mConstraints.getMaxHopNum();
+	std::vector<int> spur_path;
+	double spur_cost;
+	for (int i = deviation_index; i < path_length - 1; ++i)
+	{
+		// the next vertices of the results sharing the root path are blocked from the spur vertex
+		std::vector<int> blocked_successors;
+		for (size_t r = 0; r < mvResultIndices.size(); ++r)
+		{
+			const std::vector<int> &result = mvResultIndices[r];
+			if ((int)result.size() > i + 1 && std::equal(cur_indices.begin(), cur_indices.begin() + i + 1, result.begin()))
+			{
+				blocked_successors.push_back(result[i + 1]);
+			}
+		}
+		// the states of the root path are not entered again
+		++mStamp;
+		for (int j = 0; j < i; ++j)
+		{
+			mvBlockedStamp[(size_t)cur_indices[j] * (mStageNum + 1) + stages[j]] = mStamp;
+		}
+
+		double cost_budget = max_cost < Graph::DISCONNECT ? max_cost - costs[i] : Graph::DISCONNECT;
+		if (!searchSpur(cur_indices[i], stages[i], max_hop_num < 0 ? -1 : max_hop_num - i, cost_budget, blocked_successors, spur_path, spur_cost))
+		{
+			continue;
+		}
+		std::vector<int> candidate_indices(cur_indices.begin(), cur_indices.begin() + i);
+		candidate_indices.insert(candidate_indices.end(), spur_path.begin(), spur_path.end());
+		if (msKnownPaths.insert(candidate_indices).second)
+		{
+			++mGeneratedPathNum;
+			BasePath *candidate = makePath(candidate_indices, costs[i] + spur_cost);
+			mqPathCandidates.insert(candidate);
+			mmDeviationIndex[candidate] = i;
+		}
+	}
+	return cur_path;
+}
+
+BasePath *ConstrainedYen::getShortestPath(BaseVertex *pSource, BaseVertex *pTarget)
+{
+	mpSourceVertex = pSource;
+	mpTargetVertex = pTarget;
+	initialize();
+	std::vector<BaseVertex *> vertex_list;
+	if (!hasNext())
+	{
+		return new BasePath(vertex_list, Graph::DISCONNECT);
+	}
+	BasePath *shortest_path = *(mqPathCandidates.begin());
+	for (int i = 0; i < shortest_path->length(); ++i)
+	{
+		vertex_list.push_back(shortest_path->getVertex(i));
+	}
+	return new Path(vertex_list, shortest_path->Weight());
+}
+
+void ConstrainedYen::getShortestPaths(BaseVertex *pSource, BaseVertex *pTarget, int top_k, std::vector<BasePath *> &result_list)
+{
+	mpSourceVertex = pSource;
+	mpTargetVertex = pTarget;
+	initialize();
+	mRemainingPathNum = top_k;
+	int count = 0;
+	while (hasNext() && count < top_k)
+	{
+		next();
+		++count;
+	}
+	result_list.assign(mvResultList.begin(), mvResultList.end());
+}
@@ -0,0 +1,89 @@
+#ifndef __CONSTRAINEDYEN_H__
+#define __CONSTRAINEDYEN_H__
+
+/* Yen's algorithm for the top k shortest paths meeting a set of PathConstraints, enforced inside the searches
+instead of filtering the output of Yen.
+A spur path is searched by Dijkstra over the states (vertex, via points passed, hops), so that the hop limit,
+the forbidden vertices and edges, the via points and the cost ceiling hold for every candidate generated.
+States are pruned by lower bounds of the cost and of the hops left to the target through the remaining via points,
+computed once per query by reverse searches from the target and from every via point; a spur vertex whose
+bounds already break the budgets left by its root path is skipped without any search.
+A path is loopless between two via points, it may come back to a vertex after passing a via point.
+Spur vertices start at the deviation vertex of a path (Lawler), and the graph is never modified,
+so that several queries can share one graph from parallel threads.
+The returned paths belong to the object and live until clear() or its destruction. */
+class ConstrainedYen
+{
+public:
+	ConstrainedYen(Graph &graph, const PathConstraints &constraints) : ConstrainedYen(graph, constraints, NULL, NULL) {}
+	ConstrainedYen(Graph &graph, const PathConstraints &constraints, BaseVertex* pSource, BaseVertex* pTarget);
+	~ConstrainedYen(void);
+
+	bool 		hasNext();
+	BasePath*	next();
+	/* Constrained counterpart of Dijkstra::getShortestPath, the path belongs to the caller */
+	BasePath*	getShortestPath(BaseVertex* pSource, BaseVertex* pTarget);
+	/* Knowing k, the spur searches are also bounded by the cost of the k-th candidate:
+	the object is done with the query afterwards */
+	void 		getShortestPaths(BaseVertex* pSource, BaseVertex* pTarget, int top_k, std::vector<BasePath*>&);
+	void 		clear();
+
+	/* New candidates found, spur searches run, and spur vertices skipped by the bounds of their first edges */
+	int 		getGeneratedPathNum() const 		{ return mGeneratedPathNum; }
+	int 		getSpurSearchNum() const 			{ return mSpurSearchNum; }
+	int 		getPrunedSpurNum() const 			{ return mPrunedSpurNum; }
+
+protected:
+	void 		computeBounds();
+	int 		advanceStage(int vertex, int stage) const;
+	double 		costBound(int vertex, int stage) const;
+	int 		hopBound(int vertex, int stage) const;
+	bool 		searchSpur(int spur, int stage, int hop_budget, double cost_budget, const std::vector<int> &blocked_successors,
+						   std::vector<int> &spur_path, double &spur_cost);
+	BasePath*	makePath(const std::vector<int> &path, double cost) const;
+
+private:
+	/* A state reached by the spur search, linked to the label it was reached from */
+	struct Label
+	{
+		int 	vertex;
+		int 	stage;
+		int 	hops;
+		double 	cost;
+		int 	parent;
+	};
+
+	FlatGraph 										mFlatGraph;
+	PathConstraints 								mConstraints;
+	BaseVertex*										mpSourceVertex;
+	BaseVertex*										mpTargetVertex;
+	int 											mStageNum;
+	std::vector<int> 								mvViaIndices;
+	std::vector<char> 								mvIsForbiddenVertex;
+	std::vector<char> 								mvIsForbiddenEdge;
+	std::vector<std::vector<double>> 				mvCostToAnchor;
+	std::vector<std::vector<int>> 					mvHopsToAnchor;
+	std::vector<double> 							mvChainCost;
+	std::vector<int> 								mvChainHops;
+
+	std::vector<BasePath*> 							mvResultList;
+	std::vector<std::vector<int>> 					mvResultIndices;
+	std::map<BasePath*, int> 						mmDeviationIndex;
+	std::multiset<BasePath*, WeightLess<BasePath>> 	mqPathCandidates;
+	std::set<std::vector<int>> 						msKnownPaths;
+	int 											mRemainingPathNum;
+
+	std::vector<Label> 								mvLabels;
+	std::vector<int> 								mvStateStamp;
+	std::vector<int> 								mvSettledHops;
+	std::vector<int> 								mvBlockedStamp;
+	int 											mStamp;
+
+	int 											mGeneratedPathNum;
+	int 											mSpurSearchNum;
+	int 											mPrunedSpurNum;
+
+	void initialize();
+};
+
+#endif // __CONSTRAINEDYEN_H__
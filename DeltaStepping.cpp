@@ -0,0 +1,368 @@
+#include <set>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "Dijkstra.h"
+#include "FlatGraph.h"
+#include "DeltaStepping.h"
+
+/* Vertices handed to a thread at once in a parallel round */
+static const int CHUNK_SIZE = 256;
+
+/* Fixed team of threads running one phase function at a time; the calling thread takes part as thread 0. */
+class WorkerTeam
+{
+public:
+	WorkerTeam(int thread_num) : mpPhase(NULL), mGeneration(0), mPendingNum(0), mIsStopping(false)
+	{
+		for (int i = 1; i < thread_num; ++i)
+		{
+			mvThreads.push_back(std::thread(&WorkerTeam::loop, this, i));
+		}
+	}
+	~WorkerTeam(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsStopping = true;
+		}
+		mStartCondition.notify_all();
+		for (size_t i = 0; i < mvThreads.size(); ++i)
+		{
+			mvThreads[i].join();
+		}
+	}
+
+	void run(const std::function<void(int)> &phase)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mpPhase = &phase;
+			mPendingNum = mvThreads.size();
+			++mGeneration;
+		}
+		mStartCondition.notify_all();
+		phase(0);
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDoneCondition.wait(lock, [this]() { return mPendingNum == 0; });
+	}
+
+private:
+	std::vector<std::thread> 				mvThreads;
+	std::mutex 								mMutex;
+	std::condition_variable 				mStartCondition;
+	std::condition_variable 				mDoneCondition;
+	const std::function<void(int)>* 		mpPhase;
+	int 									mGeneration;
+	int 									mPendingNum;
+	bool 									mIsStopping;
+
+	void loop(int thread_index)
+	{
+		int seen_generation = 0;
+		while (true)
+		{
+			const std::function<void(int)> *phase;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mStartCondition.wait(lock, [&]() { return mIsStopping || mGeneration != seen_generation; });
+				if (mIsStopping)
+				{
+					return;
+				}
+				seen_generation = mGeneration;
+				phase = mpPhase;
+			}
+			(*phase)(thread_index);
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mPendingNum == 0)
+			{
+				mDoneCondition.notify_one();
+			}
+		}
+	}
+};
+
+static inline unsigned long long toBits(double distance)
+{
+	unsigned long long bits;
+	memcpy(&bits, &distance, sizeof(bits));
+	return bits;
+}
+
+static inline double fromBits(unsigned long long bits)
+{
+	double distance;
+	memcpy(&distance, &bits, sizeof(distance));
+	return distance;
+}
+
+/* Lower the distance to the new value if smaller, return whether it did */
+static inline bool atomicMin(std::atomic<unsigned long long> &distance_bits, double distance)
+{
+	unsigned long long new_bits = toBits(distance);
+	unsigned long long cur_bits = distance_bits.load(std::memory_order_relaxed);
+	while (new_bits < cur_bits)
+	{
+		if (distance_bits.compare_exchange_weak(cur_bits, new_bits, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+DeltaStepping::DeltaStepping(Graph *pGraph, int thread_num, double delta)
+	: mpGraph(pGraph), mFlatGraph(*pGraph), mThreadNum(std::max(1, thread_num)), mDelta(delta),
+	  mvDistanceBits(mFlatGraph.getVertexNum()), mvThreadBuckets(mThreadNum), mNextChunk(0)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		mmVertexIdIndex[mFlatGraph.getVertex(v)->getID()] = v;
+	}
+	if (mDelta <= 0)
+	{
+		double total_weight = 0;
+		for (int e = 0; e < mFlatGraph.getEdgeNum(); ++e)
+		{
+			total_weight += mFlatGraph.outWeight(e);
+		}
+		mDelta = mFlatGraph.getEdgeNum() > 0 ? total_weight / mFlatGraph.getEdgeNum() : 1;
+		mDelta = mDelta > 0 ? mDelta : 1;
+	}
+	mpWorkerTeam = new WorkerTeam(mThreadNum);
+}
+
+DeltaStepping::~DeltaStepping(void)
+{
+	delete mpWorkerTeam;
+}
+
+/* Take the vertices and edges currently removed from the graph, e.g. by Yen's algorithm. */
+void DeltaStepping::collectRemovals()
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	mvIsRemoved.assign(vertex_num, 0);
+	const std::set<int> &removed_vertex_ids = mpGraph->getRemovedVertexIds();
+	for (std::set<int>::const_iterator pos = removed_vertex_ids.begin(); pos != removed_vertex_ids.end(); ++pos)
+	{
+		std::map<int, int>::const_iterator index_pos = mmVertexIdIndex.find(*pos);
+		if (index_pos != mmVertexIdIndex.end())
+		{
+			mvIsRemoved[index_pos->second] = 1;
+		}
+	}
+	mvRemovedEdgeCodes.clear();
+	const std::set<std::pair<int, int>> &removed_edges = mpGraph->getRemovedEdges();
+	for (std::set<std::pair<int, int>>::const_iterator pos = removed_edges.begin(); pos != removed_edges.end(); ++pos)
+	{
+		std::map<int, int>::const_iterator start_pos = mmVertexIdIndex.find(pos->first);
+		std::map<int, int>::const_iterator end_pos = mmVertexIdIndex.find(pos->second);
+		if (start_pos != mmVertexIdIndex.end() && end_pos != mmVertexIdIndex.end())
+		{
+			mvRemovedEdgeCodes.push_back((long long)start_pos->second * vertex_num + end_pos->second);
+		}
+	}
+	std::sort(mvRemovedEdgeCodes.begin(), mvRemovedEdgeCodes.end());
+}
+
+void DeltaStepping::getShortestPathFlower(BaseVertex *root)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	collectRemovals();
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		mvDistanceBits[v].store(toBits(std::numeric_limits<double>::infinity()), std::memory_order_relaxed);
+	}
+	for (int t = 0; t < mThreadNum; ++t)
+	{
+		mvThreadBuckets[t].clear();
+	}
+
+	int root_index = root->getIndex();
+	mvDistanceBits[root_index].store(toBits(0));
+	mvThreadBuckets[0].push_back(std::vector<int>(1, root_index));
+
+	// a vertex is taken once per round and once per bucket in the heavy edge phase
+	std::vector<int> round_stamps(vertex_num, -1), bucket_stamps(vertex_num, -1);
+	std::vector<int> frontier, settled;
+	int round = 0;
+	for (size_t bucket = 0;; ++bucket)
+	{
+		// move on to the first non-empty bucket of any thread
+		size_t next_bucket = std::numeric_limits<size_t>::max();
+		for (int t = 0; t < mThreadNum; ++t)
+		{
+			for (size_t b = bucket; b < mvThreadBuckets[t].size() && b < next_bucket; ++b)
+			{
+				if (!mvThreadBuckets[t][b].empty())
+				{
+					next_bucket = b;
+				}
+			}
+		}
+		if (next_bucket == std::numeric_limits<size_t>::max())
+		{
+			break;
+		}
+		bucket = next_bucket;
+
+		// settle the bucket by rounds over the light edges, which may refill it
+		settled.clear();
+		while (true)
+		{
+			frontier.clear();
+			for (int t = 0; t < mThreadNum; ++t)
+			{
+				if (bucket >= mvThreadBuckets[t].size())
+				{
+					continue;
+				}
+				std::vector<int> &entries = mvThreadBuckets[t][bucket];
+				for (size_t i = 0; i < entries.size(); ++i)
+				{
+					int v = entries[i];
+					// skip duplicates and vertices improved since, these being in an earlier bucket already processed
+					if (round_stamps[v] != round && (size_t)(fromBits(mvDistanceBits[v].load(std::memory_order_relaxed)) / mDelta) == bucket)
+					{
+						round_stamps[v] = round;
+						frontier.push_back(v);
+					}
+				}
+				entries.clear();
+			}
+			++round;
+			if (frontier.empty())
+			{
+				break;
+			}
+			for (size_t i = 0; i < frontier.size(); ++i)
+			{
+				if (bucket_stamps[frontier[i]] != (int)bucket)
+				{
+					bucket_stamps[frontier[i]] = bucket;
+					settled.push_back(frontier[i]);
+				}
+			}
+			mNextChunk = 0;
+			mpWorkerTeam->run([&](int thread_index) { relaxEdges(thread_index, frontier, true); });
+		}
+
+		// the heavy edges lead out of the bucket, once is enough
+		mNextChunk = 0;
+		mpWorkerTeam->run([&](int thread_index) { relaxEdges(thread_index, settled, false); });
+	}
+	buildPredecessors(root_index);
+}
+
+/* Relax the light or heavy fan-in edges of the listed vertices, chunk by chunk */
+void DeltaStepping::relaxEdges(int thread_index, const std::vector<int> &vertex_list, bool is_light)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	std::vector<std::vector<int>> &buckets = mvThreadBuckets[thread_index];
+	for (int chunk = mNextChunk++; chunk * CHUNK_SIZE < (int)vertex_list.size(); chunk = mNextChunk++)
+	{
+		int chunk_end = std::min((int)vertex_list.size(), (chunk + 1) * CHUNK_SIZE);
+		for (int i = chunk * CHUNK_SIZE; i < chunk_end; ++i)
+		{
+			int v = vertex_list[i];
+			double distance = fromBits(mvDistanceBits[v].load(std::memory_order_relaxed));
+			for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+			{
+				double weight = mFlatGraph.inWeight(e);
+				int u = mFlatGraph.inSource(e);
+				if ((weight <= mDelta) != is_light || mvIsRemoved[u])
+				{
+					continue;
+				}
+				if (!mvRemovedEdgeCodes.empty() && std::binary_search(mvRemovedEdgeCodes.begin(), mvRemovedEdgeCodes.end(), (long long)u * vertex_num + v))
+				{
+					continue;
+				}
+				double fresh_distance = distance + weight;
+				if (atomicMin(mvDistanceBits[u], fresh_distance))
+				{
+					size_t bucket = (size_t)(fresh_distance / mDelta);
+					if (bucket >= buckets.size())
+					{
+						buckets.resize(bucket + 1);
+					}
+					buckets[bucket].push_back(u);
+				}
+			}
+		}
+	}
+}
+
+/* Every final distance is the one of a successor plus the edge weight, exactly as computed in the search.
+Following such tight edges from the root gives a tree whatever the order of the parallel updates was. */
+void DeltaStepping::buildPredecessors(int root)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	mvPredecessors.assign(vertex_num, -1);
+	std::vector<char> is_reached(vertex_num, 0);
+	std::queue<int> vertex_queue;
+	vertex_queue.push(root);
+	is_reached[root] = 1;
+	while (!vertex_queue.empty())
+	{
+		int v = vertex_queue.front();
+		vertex_queue.pop();
+		double distance = fromBits(mvDistanceBits[v].load(std::memory_order_relaxed));
+		for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+		{
+			int u = mFlatGraph.inSource(e);
+			if (is_reached[u] || mvIsRemoved[u] || fromBits(mvDistanceBits[u].load(std::memory_order_relaxed)) != distance + mFlatGraph.inWeight(e))
+			{
+				continue;
+			}
+			if (!mvRemovedEdgeCodes.empty() && std::binary_search(mvRemovedEdgeCodes.begin(), mvRemovedEdgeCodes.end(), (long long)u * vertex_num + v))
+			{
+				continue;
+			}
+			is_reached[u] = 1;
+			mvPredecessors[u] = v;
+			vertex_queue.push(u);
+		}
+	}
+}
+
+double DeltaStepping::getStartDistanceAt(BaseVertex *vertex) const
+{
+	double distance = fromBits(mvDistanceBits[vertex->getIndex()].load(std::memory_order_relaxed));
+	return distance < std::numeric_limits<double>::infinity() ? distance : Graph::DISCONNECT;
+}
+
+BaseVertex *DeltaStepping::getPredecessorVertex(BaseVertex *vertex) const
+{
+	int predecessor = mvPredecessors[vertex->getIndex()];
+	return predecessor < 0 ? NULL : mFlatGraph.getVertex(predecessor);
+}
+
+void DeltaStepping::exportTo(Dijkstra &dijkstra) const
+{
+	dijkstra.clear();
+	for (int v = 0; v < mFlatGraph.getVertexNum(); ++v)
+	{
+		double distance = fromBits(mvDistanceBits[v].load(std::memory_order_relaxed));
+		if (distance < std::numeric_limits<double>::infinity())
+		{
+			dijkstra.setStartDistanceAt(mFlatGraph.getVertex(v), distance);
+			if (mvPredecessors[v] >= 0)
+			{
+				dijkstra.setPredecessorVertex(mFlatGraph.getVertex(v), mFlatGraph.getVertex(mvPredecessors[v]));
+			}
+		}
+	}
+}
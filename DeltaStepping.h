@@ -0,0 +1,50 @@
+#ifndef __DELTASTEPPING_H__
+#define __DELTASTEPPING_H__
+
+#include <atomic>
+
+class WorkerTeam;
+
+/* Multi-threaded delta-stepping search building the same reverse shortest path tree as
+Dijkstra::getShortestPathFlower, i.e. the distance from every vertex to the root.
+Vertices are kept in buckets of width delta; the vertices of the current bucket are settled in parallel rounds
+over the light edges (weight <= delta), then their heavy edges are relaxed once. Distances are updated
+with an atomic minimum, and each thread queues the vertices it improved in its own bucket buffers.
+The graph is taken as a snapshot at construction; vertices and edges removed from it afterwards are skipped. */
+class DeltaStepping
+{
+public:
+	/* A delta of 0 picks the average edge weight */
+	DeltaStepping(Graph *pGraph, int thread_num, double delta = 0);
+	~DeltaStepping(void);
+
+	void 		getShortestPathFlower(BaseVertex* root);
+	double 		getStartDistanceAt(BaseVertex* vertex) const;
+	BaseVertex*	getPredecessorVertex(BaseVertex* vertex) const;
+	/* Hand the tree over to a Dijkstra object, e.g. for the cost updates of Yen's algorithm */
+	void 		exportTo(Dijkstra &dijkstra) const;
+	double 		getDelta() const 									{ return mDelta; }
+	int 		getThreadNum() const 								{ return mThreadNum; }
+
+protected:
+	void 		relaxEdges(int thread_index, const std::vector<int> &vertex_list, bool is_light);
+	void 		buildPredecessors(int root);
+	void 		collectRemovals();
+
+private:
+	Graph* 												mpGraph;
+	FlatGraph 											mFlatGraph;
+	int 												mThreadNum;
+	double 												mDelta;
+	WorkerTeam* 										mpWorkerTeam;
+	std::map<int, int> 									mmVertexIdIndex;
+	/* Search state: distances as the bits of non-negative doubles, whose integer order is the numeric one */
+	std::vector<std::atomic<unsigned long long>> 		mvDistanceBits;
+	std::vector<int> 									mvPredecessors;
+	std::vector<char> 									mvIsRemoved;
+	std::vector<long long> 								mvRemovedEdgeCodes;
+	std::vector<std::vector<std::vector<int>>> 			mvThreadBuckets;
+	std::atomic<int> 									mNextChunk;
+};
+
+#endif // __DELTASTEPPING_H__
@@ -4,6 +4,8 @@
 #include "BaseGraph.h"
 #include "Graph.h"
 #include "Dijkstra.h"
+#include "MonotoneQueue.h"
+#include "Instrument.h"
 
 BasePath *Dijkstra::getShortestPath(BaseVertex *source, BaseVertex *sink)
 {
@@ -31,46 +33,121 @@ BasePath *Dijkstra::getShortestPath(BaseVertex *source, BaseVertex *sink)
 
 void Dijkstra::determineShortestPaths(BaseVertex *source, BaseVertex *sink, bool is_source2sink)
 {
+	INSTRUMENT_SCOPE(SHORTEST_PATHS);
 	// clear the intermediate variables
 	clear();
 
 	// initiate the local variables
 	BaseVertex *end_vertex = is_source2sink ? sink : source;
 	BaseVertex *start_vertex = is_source2sink ? source : sink;
+	if (mpDirectGraph->isQuantized())
+	{
+		if (mpDirectGraph->getMaxIntEdgeWeight() <= MAX_BUCKET_WEIGHT)
+		{
+			BucketQueue<BaseVertex *> candidates(mpDirectGraph->getMaxIntEdgeWeight());
+			determineIntShortestPaths(candidates, start_vertex, end_vertex, is_source2sink);
+		}
+		else
+		{
+			RadixHeap<BaseVertex *> candidates;
+			determineIntShortestPaths(candidates, start_vertex, end_vertex, is_source2sink);
+		}
+		return;
+	}
 	mmStartDistanceIndex[start_vertex] = 0;
-	start_vertex->Weight(0);
-	mqCandidateVertices.insert(start_vertex);
+	mqCandidateVertices.insert(CandidateEntry(start_vertex, 0));
 
 	// start searching for the shortest path
 	while (!mqCandidateVertices.empty())
 	{
-		std::multiset<BaseVertex *, WeightLess<BaseVertex>>::const_iterator pos = mqCandidateVertices.begin();
-		BaseVertex *cur_vertex_pt = *pos; // mqCandidateVertices.top();
+		std::multiset<CandidateEntry, WeightLess<CandidateEntry>>::const_iterator pos = mqCandidateVertices.begin();
+		BaseVertex *cur_vertex_pt = pos->getVertex(); // mqCandidateVertices.top();
 		mqCandidateVertices.erase(pos);
 		if (cur_vertex_pt == end_vertex)
 		{
 			break;
 		}
 		msDeterminedVertices.insert(cur_vertex_pt->getID());
+		INSTRUMENT_COUNT(SETTLED_VERTICES);
 		improve2Vertex(cur_vertex_pt, is_source2sink);
 	}
 }
 
+/* Same search on integer weights (in number of weight units) with a monotone queue.
+Improved vertices are queued again rather than moved in the queue, outdated entries are skipped when popped. */
+template <class Queue>
+void Dijkstra::determineIntShortestPaths(Queue &candidates, BaseVertex *start_vertex, BaseVertex *end_vertex, bool is_source2sink)
+{
+	double weight_unit = mpDirectGraph->getWeightUnit();
+	std::map<BaseVertex *, unsigned long long> int_distance_index;
+	int_distance_index[start_vertex] = 0;
+	mmStartDistanceIndex[start_vertex] = 0;
+	candidates.push(0, start_vertex);
+
+	while (!candidates.empty())
+	{
+		std::pair<unsigned long long, BaseVertex *> item = candidates.pop();
+		BaseVertex *cur_vertex_pt = item.second;
+		if (msDeterminedVertices.find(cur_vertex_pt->getID()) != msDeterminedVertices.end())
+		{
+			continue;
+		}
+		if (cur_vertex_pt == end_vertex)
+		{
+			break;
+		}
+		msDeterminedVertices.insert(cur_vertex_pt->getID());
+		INSTRUMENT_COUNT(SETTLED_VERTICES);
+
+		std::set<BaseVertex *> neighbor_vertex_set;
+		if (is_source2sink)
+		{
+			mpDirectGraph->getAdjacentVertices(cur_vertex_pt, neighbor_vertex_set);
+		}
+		else
+		{
+			mpDirectGraph->getPrecedentVertices(cur_vertex_pt, neighbor_vertex_set);
+		}
+		for (std::set<BaseVertex *>::const_iterator pos = neighbor_vertex_set.begin(); pos != neighbor_vertex_set.end(); ++pos)
+		{
+			if (msDeterminedVertices.find((*pos)->getID()) != msDeterminedVertices.end())
+			{
+				continue;
+			}
+			INSTRUMENT_COUNT(RELAXATIONS);
+			long long weight = is_source2sink ? mpDirectGraph->getIntEdgeWeight(cur_vertex_pt, *pos) : mpDirectGraph->getIntEdgeWeight(*pos, cur_vertex_pt);
+			if (weight < 0)
+			{
+				continue;
+			}
+			unsigned long long distance = item.first + weight;
+			std::map<BaseVertex *, unsigned long long>::iterator dist_pos = int_distance_index.find(*pos);
+			if (dist_pos == int_distance_index.end() || dist_pos->second > distance)
+			{
+				int_distance_index[*pos] = distance;
+				mmStartDistanceIndex[*pos] = distance * weight_unit;
+				mmPredecessorVertex[*pos] = cur_vertex_pt;
+				candidates.push(distance, *pos);
+			}
+		}
+	}
+}
+
 void Dijkstra::improve2Vertex(BaseVertex *cur_vertex_pt, bool is_source2sink)
 {
 	// get the neighboring vertices
-	std::set<BaseVertex *> *neighbor_vertex_list_pt = new std::set<BaseVertex *>();
+	std::set<BaseVertex *> neighbor_vertex_list;
 	if (is_source2sink)
 	{
-		mpDirectGraph->getAdjacentVertices(cur_vertex_pt, *neighbor_vertex_list_pt);
+		mpDirectGraph->getAdjacentVertices(cur_vertex_pt, neighbor_vertex_list);
 	}
 	else
 	{
-		mpDirectGraph->getPrecedentVertices(cur_vertex_pt, *neighbor_vertex_list_pt);
+		mpDirectGraph->getPrecedentVertices(cur_vertex_pt, neighbor_vertex_list);
 	}
 
 	// update the distance passing on the current vertex
-	for (std::set<BaseVertex *>::iterator cur_neighbor_pos = neighbor_vertex_list_pt->begin(); cur_neighbor_pos != neighbor_vertex_list_pt->end(); ++cur_neighbor_pos)
+	for (std::set<BaseVertex *>::iterator cur_neighbor_pos = neighbor_vertex_list.begin(); cur_neighbor_pos != neighbor_vertex_list.end(); ++cur_neighbor_pos)
 	{
 		// skip if it has been visited before
 		if (msDeterminedVertices.find((*cur_neighbor_pos)->getID()) != msDeterminedVertices.end())
@@ -79,6 +156,7 @@ void Dijkstra::improve2Vertex(BaseVertex *cur_vertex_pt, bool is_source2sink)
 		}
 
 		// calculate the distance
+		INSTRUMENT_COUNT(RELAXATIONS);
 		std::map<BaseVertex *, double>::const_iterator cur_pos = mmStartDistanceIndex.find(cur_vertex_pt);
 		double distance = cur_pos != mmStartDistanceIndex.end() ? cur_pos->second : Graph::DISCONNECT;
 		distance += is_source2sink ? mpDirectGraph->getEdgeWeight(cur_vertex_pt, *cur_neighbor_pos) : mpDirectGraph->getEdgeWeight(*cur_neighbor_pos, cur_vertex_pt);
@@ -87,55 +165,76 @@ void Dijkstra::improve2Vertex(BaseVertex *cur_vertex_pt, bool is_source2sink)
 		cur_pos = mmStartDistanceIndex.find(*cur_neighbor_pos);
 		if (cur_pos == mmStartDistanceIndex.end() || cur_pos->second > distance)
 		{
-			mmStartDistanceIndex[*cur_neighbor_pos] = distance;
-			mmPredecessorVertex[*cur_neighbor_pos] = cur_vertex_pt;
-			(*cur_neighbor_pos)->Weight(distance);
-			std::multiset<BaseVertex *, WeightLess<BaseVertex>>::const_iterator pos = mqCandidateVertices.begin();
-			for (; pos != mqCandidateVertices.end(); ++pos)
+			// a vertex with a distance and not determined yet is queued with that distance: move it
+			if (cur_pos != mmStartDistanceIndex.end())
 			{
-				if ((*pos)->getID() == (*cur_neighbor_pos)->getID())
+				typedef std::multiset<CandidateEntry, WeightLess<CandidateEntry>>::const_iterator CandidateIterator;
+				std::pair<CandidateIterator, CandidateIterator> range = mqCandidateVertices.equal_range(CandidateEntry(NULL, cur_pos->second));
+				for (CandidateIterator pos = range.first; pos != range.second; ++pos)
 				{
-					break;
+					if (pos->getVertex() == *cur_neighbor_pos)
+					{
+						mqCandidateVertices.erase(pos);
+						break;
+					}
 				}
 			}
-			if (pos != mqCandidateVertices.end())
-			{
-				mqCandidateVertices.erase(pos);
-			}
-			mqCandidateVertices.insert(*cur_neighbor_pos);
+			mmStartDistanceIndex[*cur_neighbor_pos] = distance;
+			mmPredecessorVertex[*cur_neighbor_pos] = cur_vertex_pt;
+			mqCandidateVertices.insert(CandidateEntry(*cur_neighbor_pos, distance));
 		}
 	}
 }
 
+double Dijkstra::getStartDistanceAt(BaseVertex *vertex)
+{
+	std::map<BaseVertex *, double>::const_iterator pos = mmStartDistanceIndex.find(vertex);
+	return pos != mmStartDistanceIndex.end() ? pos->second : Graph::DISCONNECT;
+}
+
+BaseVertex *Dijkstra::getPredecessorVertex(BaseVertex *vertex) const
+{
+	std::map<BaseVertex *, BaseVertex *>::const_iterator pos = mmPredecessorVertex.find(vertex);
+	return pos != mmPredecessorVertex.end() ? pos->second : NULL;
+}
+
 void Dijkstra::clear()
 {
+	mIsJournaling = false;
+	mvJournal.clear();
 	msDeterminedVertices.clear();
 	mmPredecessorVertex.clear();
 	mmStartDistanceIndex.clear();
 	mqCandidateVertices.clear();
 }
 
-BasePath *Dijkstra::updateCostForward(BaseVertex *vertex)
+BasePath *Dijkstra::updateCostForward(BaseVertex *vertex, double max_distance)
 {
+	INSTRUMENT_SCOPE(UPDATE_COST_FORWARD);
 	double cost = Graph::DISCONNECT;
 
 	// get the set of successors of the input vertex
-	std::set<BaseVertex *> *adj_vertex_set = new std::set<BaseVertex *>();
-	mpDirectGraph->getAdjacentVertices(vertex, *adj_vertex_set);
+	std::set<BaseVertex *> adj_vertex_set;
+	mpDirectGraph->getAdjacentVertices(vertex, adj_vertex_set);
 
 	// make sure the input vertex exists in the index
 	std::map<BaseVertex *, double>::iterator pos4vertexInStartDistIndex = mmStartDistanceIndex.find(vertex);
 	if (pos4vertexInStartDistIndex == mmStartDistanceIndex.end())
 	{
+		journal(vertex);
 		pos4vertexInStartDistIndex = (mmStartDistanceIndex.insert(std::make_pair(vertex, Graph::DISCONNECT))).first;
 	}
 
 	// update the distance from the root to the input vertex if necessary
-	for (std::set<BaseVertex *>::const_iterator pos = adj_vertex_set->begin(); pos != adj_vertex_set->end(); ++pos)
+	for (std::set<BaseVertex *>::const_iterator pos = adj_vertex_set.begin(); pos != adj_vertex_set.end(); ++pos)
 	{
 		// get the distance from the root to one successor of the input vertex
 		std::map<BaseVertex *, double>::const_iterator cur_vertex_pos = mmStartDistanceIndex.find(*pos);
 		double distance = cur_vertex_pos == mmStartDistanceIndex.end() ? Graph::DISCONNECT : cur_vertex_pos->second;
+		if (distance > max_distance)
+		{
+			continue;
+		}
 
 		// calculate the distance from the root to the input vertex
 		distance += mpDirectGraph->getEdgeWeight(vertex, *pos);
@@ -144,6 +243,7 @@ BasePath *Dijkstra::updateCostForward(BaseVertex *vertex)
 		double cost_of_vertex = pos4vertexInStartDistIndex->second;
 		if (cost_of_vertex > distance)
 		{
+			journal(vertex);
 			mmStartDistanceIndex[vertex] = distance;
 			mmPredecessorVertex[vertex] = cur_vertex_pos->first;
 			cost = distance;
@@ -168,8 +268,9 @@ BasePath *Dijkstra::updateCostForward(BaseVertex *vertex)
 	return sub_path;
 }
 
-void Dijkstra::correctCostBackward(BaseVertex *vertex)
+void Dijkstra::correctCostBackward(BaseVertex *vertex, double max_distance)
 {
+	INSTRUMENT_SCOPE(CORRECT_COST_BACKWARD);
 	// initialize the list of vertex to be updated
 	std::vector<BaseVertex *> vertex_pt_list;
 	vertex_pt_list.push_back(vertex);
@@ -179,7 +280,7 @@ void Dijkstra::correctCostBackward(BaseVertex *vertex)
 	{
 		BaseVertex *cur_vertex_pt = *(vertex_pt_list.begin());
 		vertex_pt_list.erase(vertex_pt_list.begin());
-		double cost_of_cur_vertex = mmStartDistanceIndex[cur_vertex_pt];
+		double cost_of_cur_vertex = getStartDistanceAt(cur_vertex_pt);
 		std::set<BaseVertex *> pre_vertex_set;
 		mpDirectGraph->getPrecedentVertices(cur_vertex_pt, pre_vertex_set);
 		for (std::set<BaseVertex *>::const_iterator pos = pre_vertex_set.begin(); pos != pre_vertex_set.end(); ++pos)
@@ -187,12 +288,123 @@ void Dijkstra::correctCostBackward(BaseVertex *vertex)
 			std::map<BaseVertex *, double>::const_iterator pos4StartDistIndexMap = mmStartDistanceIndex.find(*pos);
 			double cost_of_pre_vertex = mmStartDistanceIndex.end() == pos4StartDistIndexMap ? Graph::DISCONNECT : pos4StartDistIndexMap->second;
 			double fresh_cost = cost_of_cur_vertex + mpDirectGraph->getEdgeWeight(*pos, cur_vertex_pt);
-			if (cost_of_pre_vertex > fresh_cost)
+			if (cost_of_pre_vertex > fresh_cost && fresh_cost <= max_distance)
 			{
+				journal(*pos);
 				mmStartDistanceIndex[*pos] = fresh_cost;
 				mmPredecessorVertex[*pos] = cur_vertex_pt;
 				vertex_pt_list.push_back(*pos);
+				INSTRUMENT_COUNT(BACKWARD_CORRECTIONS);
+			}
+		}
+	}
+}
+
+void Dijkstra::repairFlower(const std::vector<BaseVertex *> &affected_vertices, double max_distance)
+{
+	std::set<BaseVertex *> affected_set(affected_vertices.begin(), affected_vertices.end());
+	for (std::vector<BaseVertex *>::const_iterator pos = affected_vertices.begin(); pos != affected_vertices.end(); ++pos)
+	{
+		journal(*pos);
+		mmStartDistanceIndex[*pos] = Graph::DISCONNECT;
+		mmPredecessorVertex.erase(*pos);
+	}
+	msDeterminedVertices.clear();
+	mqCandidateVertices.clear();
+
+	// an affected vertex starts from its best edge to an unaffected one
+	for (std::vector<BaseVertex *>::const_iterator pos = affected_vertices.begin(); pos != affected_vertices.end(); ++pos)
+	{
+		std::set<BaseVertex *> adj_vertex_set;
+		mpDirectGraph->getAdjacentVertices(*pos, adj_vertex_set);
+		double cost = Graph::DISCONNECT;
+		for (std::set<BaseVertex *>::const_iterator adj_pos = adj_vertex_set.begin(); adj_pos != adj_vertex_set.end(); ++adj_pos)
+		{
+			double distance = getStartDistanceAt(*adj_pos);
+			if (affected_set.find(*adj_pos) != affected_set.end() || distance > max_distance || distance >= Graph::DISCONNECT)
+			{
+				continue;
+			}
+			distance += mpDirectGraph->getEdgeWeight(*pos, *adj_pos);
+			if (distance < cost)
+			{
+				cost = distance;
+				mmPredecessorVertex[*pos] = *adj_pos;
+			}
+		}
+		if (cost < Graph::DISCONNECT)
+		{
+			mmStartDistanceIndex[*pos] = cost;
+			mqCandidateVertices.insert(CandidateEntry(*pos, cost));
+		}
+	}
+
+	// then Dijkstra among the affected vertices, improved vertices being queued again
+	while (!mqCandidateVertices.empty() && mqCandidateVertices.begin()->Weight() <= max_distance)
+	{
+		CandidateEntry entry = *mqCandidateVertices.begin();
+		mqCandidateVertices.erase(mqCandidateVertices.begin());
+		BaseVertex *cur_vertex_pt = entry.getVertex();
+		if (entry.Weight() > getStartDistanceAt(cur_vertex_pt) || !msDeterminedVertices.insert(cur_vertex_pt->getID()).second)
+		{
+			continue;
+		}
+		INSTRUMENT_COUNT(SETTLED_VERTICES);
+		std::set<BaseVertex *> pre_vertex_set;
+		mpDirectGraph->getPrecedentVertices(cur_vertex_pt, pre_vertex_set);
+		for (std::set<BaseVertex *>::const_iterator pos = pre_vertex_set.begin(); pos != pre_vertex_set.end(); ++pos)
+		{
+			if (affected_set.find(*pos) == affected_set.end() || msDeterminedVertices.find((*pos)->getID()) != msDeterminedVertices.end())
+			{
+				continue;
 			}
+			INSTRUMENT_COUNT(RELAXATIONS);
+			double distance = entry.Weight() + mpDirectGraph->getEdgeWeight(*pos, cur_vertex_pt);
+			if (distance < getStartDistanceAt(*pos))
+			{
+				mmStartDistanceIndex[*pos] = distance;
+				mmPredecessorVertex[*pos] = cur_vertex_pt;
+				mqCandidateVertices.insert(CandidateEntry(*pos, distance));
+			}
+		}
+	}
+	msDeterminedVertices.clear();
+	mqCandidateVertices.clear();
+}
+
+void Dijkstra::journal(BaseVertex *vertex)
+{
+	if (!mIsJournaling)
+	{
+		return;
+	}
+	std::map<BaseVertex *, double>::const_iterator pos = mmStartDistanceIndex.find(vertex);
+	JournalEntry entry = {vertex, pos != mmStartDistanceIndex.end(), pos != mmStartDistanceIndex.end() ? pos->second : Graph::DISCONNECT, getPredecessorVertex(vertex)};
+	mvJournal.push_back(entry);
+}
+
+/* The entries are undone from the last one, so that a vertex changed several times gets its first state back */
+void Dijkstra::rollBack()
+{
+	for (std::vector<JournalEntry>::reverse_iterator pos = mvJournal.rbegin(); pos != mvJournal.rend(); ++pos)
+	{
+		if (pos->has_distance)
+		{
+			mmStartDistanceIndex[pos->vertex] = pos->distance;
+		}
+		else
+		{
+			mmStartDistanceIndex.erase(pos->vertex);
+		}
+		if (pos->predecessor != NULL)
+		{
+			mmPredecessorVertex[pos->vertex] = pos->predecessor;
+		}
+		else
+		{
+			mmPredecessorVertex.erase(pos->vertex);
 		}
 	}
+	mvJournal.clear();
+	mIsJournaling = false;
 }
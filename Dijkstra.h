@@ -5,29 +5,72 @@
 class Dijkstra
 {
 public:
-	Dijkstra(Graph *pGraph) : mpDirectGraph(pGraph) {}
+	/* In the integer weight mode, Dial's buckets are used up to this edge weight and a radix heap beyond */
+	static const long long 	MAX_BUCKET_WEIGHT = 1 << 16;
+
+	/* Entry of the candidate queue. The distance is kept in the entry rather than in the vertex,
+	so that searches sharing the vertices of a graph can run in parallel. */
+	class CandidateEntry
+	{
+	public:
+		CandidateEntry(BaseVertex* vertex, double weight) : mpVertex(vertex), mWeight(weight) {}
+
+		BaseVertex*	getVertex() const 			{ return mpVertex; }
+		double 		Weight() const 				{ return mWeight; }
+
+	private:
+		BaseVertex* 	mpVertex;
+		double 			mWeight;
+	};
+
+	Dijkstra(Graph *pGraph) : mpDirectGraph(pGraph), mIsJournaling(false) {}
 	~Dijkstra(void) { clear(); }
 
 	BasePath*	getShortestPath(BaseVertex* source, BaseVertex* sink);
-	void 		setPredecessorVertex(BaseVertex* vt1, BaseVertex* vt2) 	{ mmPredecessorVertex[vt1] = vt2; }
-	double 		getStartDistanceAt(BaseVertex* vertex) 					{ return mmStartDistanceIndex.find(vertex)->second; }
-	void 		setStartDistanceAt(BaseVertex* vertex, double weight) 	{ mmStartDistanceIndex[vertex] = weight; }
+	void 		setPredecessorVertex(BaseVertex* vt1, BaseVertex* vt2) 	{ journal(vt1); mmPredecessorVertex[vt1] = vt2; }
+	/* The next vertex towards the root of a flower, NULL for the root and the vertices not reaching it */
+	BaseVertex*	getPredecessorVertex(BaseVertex* vertex) const;
+	double 		getStartDistanceAt(BaseVertex* vertex);
+	void 		setStartDistanceAt(BaseVertex* vertex, double weight) 	{ journal(vertex); mmStartDistanceIndex[vertex] = weight; }
 	void 		getShortestPathFlower(BaseVertex* root) 				{ determineShortestPaths(NULL, root, false); }
 	void 		clear();
 	/* For the top-k shortest paths algorithm */ 
-	BasePath*	updateCostForward(BaseVertex* vertex);
-	void 		correctCostBackward(BaseVertex* vertex);
+	/* The distances above max_distance are of no use: they are not taken from the successors, nor given to the precedents */
+	BasePath*	updateCostForward(BaseVertex* vertex, double max_distance = Graph::DISCONNECT);
+	void 		correctCostBackward(BaseVertex* vertex, double max_distance = Graph::DISCONNECT);
+	/* Search again the distances of a flower after vertices or edges were removed from the graph. The given vertices are
+	the ones whose path to the root crossed a removed element, they are reached again from the other ones, whose distances
+	still hold. Only the distances up to max_distance are settled: the distances beyond are to be ignored afterwards,
+	as the bounded updates above do, some of them being the outdated ones of vertices left out of the given list. */
+	void 		repairFlower(const std::vector<BaseVertex*> &affected_vertices, double max_distance);
+	/* Every change of a distance or predecessor from now on is recorded, rollBack() undoes them all and stops recording */
+	void 		startJournal() 											{ mvJournal.clear(); mIsJournaling = true; }
+	void 		rollBack();
 
 protected:
 	void 		determineShortestPaths(BaseVertex* source, BaseVertex* sink, bool is_source2sink);
 	void 		improve2Vertex(BaseVertex* cur_vertex_pt, bool is_source2sink);
+	template <class Queue>
+	void 		determineIntShortestPaths(Queue &candidates, BaseVertex* start_vertex, BaseVertex* end_vertex, bool is_source2sink);
+	void 		journal(BaseVertex* vertex);
 
 private:
+	/* Distance and predecessor of a vertex before a change, NULL for no predecessor */
+	struct JournalEntry
+	{
+		BaseVertex* 	vertex;
+		bool 			has_distance;
+		double 			distance;
+		BaseVertex* 	predecessor;
+	};
+
 	Graph* 												mpDirectGraph;
 	std::map<BaseVertex*, double> 						mmStartDistanceIndex;
 	std::map<BaseVertex*, BaseVertex*> 					mmPredecessorVertex;
 	std::set<int> 										msDeterminedVertices;
-	std::multiset<BaseVertex*, WeightLess<BaseVertex>> 	mqCandidateVertices;
+	std::multiset<CandidateEntry, WeightLess<CandidateEntry>> 	mqCandidateVertices;
+	bool 												mIsJournaling;
+	std::vector<JournalEntry> 							mvJournal;
 };
 
 #endif // __DIJKSTRA_H__
@@ -0,0 +1,247 @@
+#include <set>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "Dijkstra.h"
+#include "FlatGraph.h"
+#include "Eppstein.h"
+
+Eppstein::Eppstein(Graph &graph, BaseVertex *pSource, BaseVertex *pTarget)
+	: mGraph(graph), mFlatGraph(graph), mpSourceVertex(pSource), mpTargetVertex(pTarget), mHasTreeWalk(false)
+{
+	// the tail of every fan-out edge, to follow a sidetrack back to where it leaves the tree
+	mvEdgeSource.resize(mFlatGraph.getEdgeNum());
+	for (int v = 0; v < mFlatGraph.getVertexNum(); ++v)
+	{
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			mvEdgeSource[e] = v;
+		}
+	}
+	initialize();
+}
+
+Eppstein::~Eppstein(void)
+{
+	clear();
+}
+
+/* The paths returned so far are deleted as well */
+void Eppstein::clear()
+{
+	mHasTreeWalk = false;
+	mvHeapNodes.clear();
+	mvSidetracks.clear();
+	mqWalkCandidates = std::priority_queue<WalkEntry, std::vector<WalkEntry>, std::greater<WalkEntry>>();
+	for_each(mvResultList.begin(), mvResultList.end(), DeleteFunc<BasePath>());
+	mvResultList.clear();
+}
+
+void Eppstein::initialize()
+{
+	clear();
+	if (mpSourceVertex == NULL || mpTargetVertex == NULL)
+	{
+		return;
+	}
+	buildTree();
+	int source = mpSourceVertex->getIndex();
+	if (mvTreeDistance[source] >= Graph::DISCONNECT)
+	{
+		return;
+	}
+	// from the source to itself, the empty walk is left out
+	mHasTreeWalk = mpSourceVertex != mpTargetVertex;
+	int heap = getHeap(source);
+	if (heap >= 0)
+	{
+		WalkEntry entry = {mvTreeDistance[source] + mvHeapNodes[heap].key, heap, -1};
+		mqWalkCandidates.push(entry);
+	}
+}
+
+/* Tree distances and tree edges from the reverse shortest path tree of the target */
+void Eppstein::buildTree()
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	Dijkstra reverse_tree(&mGraph);
+	reverse_tree.getShortestPathFlower(mpTargetVertex);
+	mvTreeDistance.assign(vertex_num, Graph::DISCONNECT);
+	mvTreeSuccessor.assign(vertex_num, -1);
+	mvTreeEdge.assign(vertex_num, -1);
+	mvHeapRoots.assign(vertex_num, -1);
+	mvIsHeapBuilt.assign(vertex_num, 0);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		BaseVertex *vertex = mFlatGraph.getVertex(v);
+		mvTreeDistance[v] = vertex == mpTargetVertex ? 0 : reverse_tree.getStartDistanceAt(vertex);
+		BaseVertex *successor = vertex == mpTargetVertex ? NULL : reverse_tree.getPredecessorVertex(vertex);
+		if (successor == NULL || mvTreeDistance[v] >= Graph::DISCONNECT)
+		{
+			continue;
+		}
+		mvTreeSuccessor[v] = successor->getIndex();
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			if (mFlatGraph.outTarget(e) == mvTreeSuccessor[v])
+			{
+				mvTreeEdge[v] = e;
+				break;
+			}
+		}
+	}
+}
+
+/* Persistent merge: the nodes along the right spine are copied, the rest is shared */
+int Eppstein::mergeHeaps(int first, int second)
+{
+	if (first < 0 || second < 0)
+	{
+		return first < 0 ? second : first;
+	}
+	if (mvHeapNodes[second].key < mvHeapNodes[first].key)
+	{
+		std::swap(first, second);
+	}
+	HeapNode node = mvHeapNodes[first];
+	node.right = mergeHeaps(node.right, second);
+	int left_rank = node.left < 0 ? 0 : mvHeapNodes[node.left].rank;
+	int right_rank = node.right < 0 ? 0 : mvHeapNodes[node.right].rank;
+	if (left_rank < right_rank)
+	{
+		std::swap(node.left, node.right);
+		std::swap(left_rank, right_rank);
+	}
+	node.rank = right_rank + 1;
+	mvHeapNodes.push_back(node);
+	return mvHeapNodes.size() - 1;
+}
+
+/* Heap of the sidetracks out of the vertex and out of the vertices of its tree path, built along the path
+from the first vertex whose heap is already there */
+int Eppstein::getHeap(int vertex)
+{
+	std::vector<int> tree_path;
+	for (int v = vertex; v >= 0 && !mvIsHeapBuilt[v]; v = mvTreeSuccessor[v])
+	{
+		tree_path.push_back(v);
+	}
+	for (int i = tree_path.size() - 1; i >= 0; --i)
+	{
+		int v = tree_path[i];
+		int heap = mvTreeSuccessor[v] >= 0 ? mvHeapRoots[mvTreeSuccessor[v]] : -1;
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			int head = mFlatGraph.outTarget(e);
+			if (e == mvTreeEdge[v] || mvTreeDistance[head] >= Graph::DISCONNECT)
+			{
+				continue;
+			}
+			HeapNode node = {std::max(0.0, mFlatGraph.outWeight(e) + mvTreeDistance[head] - mvTreeDistance[v]), e, 1, -1, -1};
+			mvHeapNodes.push_back(node);
+			heap = mergeHeaps(heap, mvHeapNodes.size() - 1);
+		}
+		mvHeapRoots[v] = heap;
+		mvIsHeapBuilt[v] = 1;
+	}
+	return mvHeapRoots[vertex];
+}
+
+/* The tree path from the source, left at the tail of every sidetrack in turn, then the tree path to the target */
+BasePath *Eppstein::makeWalk(int sidetrack, double cost) const
+{
+	std::vector<int> edges;
+	for (int i = sidetrack; i >= 0; i = mvSidetracks[i].previous)
+	{
+		edges.push_back(mvSidetracks[i].edge);
+	}
+	std::reverse(edges.begin(), edges.end());
+
+	int target = mpTargetVertex->getIndex();
+	int v = mpSourceVertex->getIndex();
+	std::vector<BaseVertex *> vertex_list(1, mpSourceVertex);
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		while (v != mvEdgeSource[edges[i]])
+		{
+			v = mvTreeSuccessor[v];
+			vertex_list.push_back(mFlatGraph.getVertex(v));
+		}
+		v = mFlatGraph.outTarget(edges[i]);
+		vertex_list.push_back(mFlatGraph.getVertex(v));
+	}
+	while (v != target)
+	{
+		v = mvTreeSuccessor[v];
+		vertex_list.push_back(mFlatGraph.getVertex(v));
+	}
+	return new Path(vertex_list, cost);
+}
+
+bool Eppstein::hasNext()
+{
+	return mHasTreeWalk || !mqWalkCandidates.empty();
+}
+
+BasePath *Eppstein::next()
+{
+	BasePath *walk = NULL;
+	if (mHasTreeWalk)
+	{
+		// the shortest path itself, without sidetrack
+		mHasTreeWalk = false;
+		walk = makeWalk(-1, mvTreeDistance[mpSourceVertex->getIndex()]);
+	}
+	else if (!mqWalkCandidates.empty())
+	{
+		WalkEntry entry = mqWalkCandidates.top();
+		mqWalkCandidates.pop();
+		HeapNode node = mvHeapNodes[entry.heap_node];
+		Sidetrack sidetrack = {node.edge, entry.previous};
+		mvSidetracks.push_back(sidetrack);
+		int sidetrack_index = mvSidetracks.size() - 1;
+
+		// the children of the heap node take the place of its sidetrack
+		int children[2] = {node.left, node.right};
+		for (int i = 0; i < 2; ++i)
+		{
+			if (children[i] >= 0)
+			{
+				WalkEntry child_entry = {entry.cost - node.key + mvHeapNodes[children[i]].key, children[i], entry.previous};
+				mqWalkCandidates.push(child_entry);
+			}
+		}
+		// a next sidetrack from the tree path of its head
+		int heap = getHeap(mFlatGraph.outTarget(node.edge));
+		if (heap >= 0)
+		{
+			WalkEntry next_entry = {entry.cost + mvHeapNodes[heap].key, heap, sidetrack_index};
+			mqWalkCandidates.push(next_entry);
+		}
+		walk = makeWalk(sidetrack_index, entry.cost);
+	}
+	if (walk != NULL)
+	{
+		mvResultList.push_back(walk);
+	}
+	return walk;
+}
+
+void Eppstein::getShortestPaths(BaseVertex *pSource, BaseVertex *pTarget, int top_k, std::vector<BasePath *> &result_list)
+{
+	mpSourceVertex = pSource;
+	mpTargetVertex = pTarget;
+	initialize();
+	int count = 0;
+	while (hasNext() && count < top_k)
+	{
+		next();
+		++count;
+	}
+	result_list.assign(mvResultList.begin(), mvResultList.end());
+}
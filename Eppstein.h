@@ -0,0 +1,81 @@
+#ifndef __EPPSTEIN_H__
+#define __EPPSTEIN_H__
+
+/* Eppstein's algorithm for the top k shortest walks connecting a pair of vertices, i.e. paths that may
+visit a vertex more than once, in O(m + n log n + k log k) plus the length of the walks returned.
+A walk is the reverse shortest path tree of the target (Dijkstra::getShortestPathFlower) with a sequence of sidetracks,
+the edges off the tree, each costing its weight plus the tree distance of its head minus the one of its tail.
+The sidetracks reachable from a vertex along its tree path are kept in a persistent leftist heap sharing the heap of
+its tree successor. The heaps are built lazily, only for the vertices a walk comes through, and the walks are
+enumerated from a queue of heap nodes.
+It works on a snapshot of the graph, so that several queries can share one graph from parallel threads.
+The returned paths belong to the object and live until clear() or its destruction. */
+class Eppstein
+{
+public:
+	Eppstein(Graph &graph) : Eppstein(graph, NULL, NULL) {}
+	Eppstein(Graph &graph, BaseVertex* pSource, BaseVertex* pTarget);
+	~Eppstein(void);
+
+	bool 		hasNext();
+	BasePath*	next();
+	void 		getShortestPaths(BaseVertex* pSource, BaseVertex* pTarget, int top_k, std::vector<BasePath*>&);
+	void 		clear();
+
+	/* Heap nodes allocated since the query started */
+	size_t 		getHeapNodeNum() const 				{ return mvHeapNodes.size(); }
+
+protected:
+	void 		buildTree();
+	int 		getHeap(int vertex);
+	int 		mergeHeaps(int first, int second);
+	BasePath*	makeWalk(int sidetrack, double cost) const;
+
+private:
+	/* Node of a persistent leftist heap of sidetracks, keyed by their cost */
+	struct HeapNode
+	{
+		double 	key;
+		int 	edge;
+		int 	rank;
+		int 	left;
+		int 	right;
+	};
+	/* Sidetrack of a walk, after the sidetracks of the walk it derives from */
+	struct Sidetrack
+	{
+		int 	edge;
+		int 	previous;
+	};
+	/* Queued walk: the last sidetrack is the edge of the heap node */
+	struct WalkEntry
+	{
+		double 	cost;
+		int 	heap_node;
+		int 	previous;
+
+		bool operator>(const WalkEntry &other) const 	{ return cost > other.cost; }
+	};
+
+	Graph& 											mGraph;
+	FlatGraph 										mFlatGraph;
+	BaseVertex*										mpSourceVertex;
+	BaseVertex*										mpTargetVertex;
+
+	std::vector<double> 							mvTreeDistance;
+	std::vector<int> 								mvTreeSuccessor;
+	std::vector<int> 								mvTreeEdge;
+	std::vector<int> 								mvEdgeSource;
+	std::vector<int> 								mvHeapRoots;
+	std::vector<char> 								mvIsHeapBuilt;
+	std::vector<HeapNode> 							mvHeapNodes;
+
+	std::vector<Sidetrack> 							mvSidetracks;
+	std::priority_queue<WalkEntry, std::vector<WalkEntry>, std::greater<WalkEntry>> 	mqWalkCandidates;
+	bool 											mHasTreeWalk;
+	std::vector<BasePath*> 							mvResultList;
+
+	void initialize();
+};
+
+#endif // __EPPSTEIN_H__
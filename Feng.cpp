@@ -0,0 +1,352 @@
+#include <set>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "Dijkstra.h"
+#include "FlatGraph.h"
+#include "Feng.h"
+
+/* Entry of the spur search: a yellow vertex reached at the key cost, or a green exit whose key adds its tree distance */
+struct SpurEntry
+{
+	double 	key;
+	bool 	is_yellow;
+	int 	vertex;
+	int 	predecessor;
+
+	/* exits first among equal keys, they end the search */
+	bool operator>(const SpurEntry &other) const
+	{
+		return key > other.key || (key == other.key && is_yellow && !other.is_yellow);
+	}
+};
+
+Feng::Feng(Graph &graph, BaseVertex *pSource, BaseVertex *pTarget)
+	: mGraph(graph), mFlatGraph(graph), mpSourceVertex(pSource), mpTargetVertex(pTarget), mColorStamp(0), mSearchStamp(0)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	mvRedStamp.assign(vertex_num, 0);
+	mvYellowStamp.assign(vertex_num, 0);
+	mvSearchStamp.assign(vertex_num, 0);
+	mvSearchCost.assign(vertex_num, 0);
+	mvSearchPredecessor.assign(vertex_num, -1);
+	initialize();
+}
+
+Feng::~Feng(void)
+{
+	clear();
+}
+
+/* The paths returned so far are deleted as well */
+void Feng::clear()
+{
+	mGeneratedPathNum = 0;
+	mTreeSpurNum = 0;
+	mYellowSettledNum = 0;
+	mRemainingPathNum = -1;
+	mmDeviationIndex.clear();
+	mvResultPrefixTree.assign(1, std::map<int, int>());
+	for_each(mvResultList.begin(), mvResultList.end(), DeleteFunc<BasePath>());
+	mvResultList.clear();
+	for_each(mqPathCandidates.begin(), mqPathCandidates.end(), DeleteFunc<BasePath>());
+	mqPathCandidates.clear();
+}
+
+void Feng::initialize()
+{
+	clear();
+	if (mpSourceVertex != NULL && mpTargetVertex != NULL)
+	{
+		buildTree();
+		BasePath *pShortestPath = getShortestPath(mpSourceVertex, mpTargetVertex);
+		if (pShortestPath != NULL && pShortestPath->length() > 1)
+		{
+			mqPathCandidates.insert(pShortestPath);
+			mmDeviationIndex[pShortestPath] = 0;
+		}
+		else
+		{
+			delete pShortestPath;
+		}
+	}
+}
+
+BasePath *Feng::getShortestPath(BaseVertex *pSource, BaseVertex *pTarget)
+{
+	Dijkstra dijkstra_alg(&mGraph);
+	return dijkstra_alg.getShortestPath(pSource, pTarget);
+}
+
+/* Reverse shortest path tree of the target on the fan-in edges of the snapshot */
+void Feng::buildTree()
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	int target = mpTargetVertex->getIndex();
+	mvTreeDistance.assign(vertex_num, Graph::DISCONNECT);
+	mvTreeSuccessor.assign(vertex_num, -1);
+	std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>> candidates;
+	mvTreeDistance[target] = 0;
+	candidates.push(std::make_pair(0.0, target));
+	while (!candidates.empty())
+	{
+		std::pair<double, int> top = candidates.top();
+		candidates.pop();
+		int v = top.second;
+		if (top.first > mvTreeDistance[v])
+		{
+			continue;
+		}
+		for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+		{
+			int u = mFlatGraph.inSource(e);
+			double distance = top.first + mFlatGraph.inWeight(e);
+			if (distance < mvTreeDistance[u])
+			{
+				mvTreeDistance[u] = distance;
+				mvTreeSuccessor[u] = v;
+				candidates.push(std::make_pair(distance, u));
+			}
+		}
+	}
+
+	mvChildOffsets.assign(vertex_num + 1, 0);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		if (mvTreeSuccessor[v] >= 0)
+		{
+			++mvChildOffsets[mvTreeSuccessor[v] + 1];
+		}
+	}
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		mvChildOffsets[v + 1] += mvChildOffsets[v];
+	}
+	mvChildren.resize(mvChildOffsets[vertex_num]);
+	std::vector<int> child_num(vertex_num, 0);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		if (mvTreeSuccessor[v] >= 0)
+		{
+			int parent = mvTreeSuccessor[v];
+			mvChildren[mvChildOffsets[parent] + child_num[parent]++] = v;
+		}
+	}
+}
+
+/* A red vertex turns its tree subtree yellow; a yellow vertex has its subtree yellow already */
+void Feng::markRed(int vertex)
+{
+	mvRedStamp[vertex] = mColorStamp;
+	if (mvYellowStamp[vertex] == mColorStamp)
+	{
+		return;
+	}
+	std::vector<int> stack(1, vertex);
+	mvYellowStamp[vertex] = mColorStamp;
+	while (!stack.empty())
+	{
+		int v = stack.back();
+		stack.pop_back();
+		for (int c = mvChildOffsets[v]; c < mvChildOffsets[v + 1]; ++c)
+		{
+			if (mvYellowStamp[mvChildren[c]] != mColorStamp)
+			{
+				mvYellowStamp[mvChildren[c]] = mColorStamp;
+				stack.push_back(mvChildren[c]);
+			}
+		}
+	}
+}
+
+/* Least cost path from the spur vertex to the target avoiding the red vertices, the first edge not leading
+to a blocked successor: Dijkstra over the yellow vertices, ended by the first green exit popped. */
+bool Feng::searchSpur(int spur, const std::vector<int> &blocked_successors, std::vector<int> &spur_path, double &spur_cost)
+{
+	++mSearchStamp;
+	std::priority_queue<SpurEntry, std::vector<SpurEntry>, std::greater<SpurEntry>> candidates;
+	SpurEntry start = {0, true, spur, -1};
+	candidates.push(start);
+	mvSearchStamp[spur] = mSearchStamp;
+	mvSearchCost[spur] = 0;
+	mvSearchPredecessor[spur] = -1;
+	int settled_num = 0;
+	while (!candidates.empty())
+	{
+		SpurEntry top = candidates.top();
+		candidates.pop();
+		if (!top.is_yellow)
+		{
+			// the yellow part back to the spur vertex, then the tree path of the exit
+			spur_cost = top.key;
+			spur_path.clear();
+			for (int v = top.predecessor; v >= 0; v = mvSearchPredecessor[v])
+			{
+				spur_path.push_back(v);
+			}
+			std::reverse(spur_path.begin(), spur_path.end());
+			for (int v = top.vertex; v >= 0; v = mvTreeSuccessor[v])
+			{
+				spur_path.push_back(v);
+			}
+			mTreeSpurNum += settled_num == 0 ? 1 : 0;
+			return true;
+		}
+		if (top.key > mvSearchCost[top.vertex])
+		{
+			continue;
+		}
+		if (top.vertex != spur)
+		{
+			++settled_num;
+			++mYellowSettledNum;
+		}
+
+		for (int e = mFlatGraph.outBegin(top.vertex); e < mFlatGraph.outEnd(top.vertex); ++e)
+		{
+			int u = mFlatGraph.outTarget(e);
+			if (mvRedStamp[u] == mColorStamp ||
+				(top.vertex == spur && std::find(blocked_successors.begin(), blocked_successors.end(), u) != blocked_successors.end()))
+			{
+				continue;
+			}
+			double cost = top.key + mFlatGraph.outWeight(e);
+			if (mvYellowStamp[u] == mColorStamp)
+			{
+				if (mvSearchStamp[u] == mSearchStamp && mvSearchCost[u] <= cost)
+				{
+					continue;
+				}
+				mvSearchStamp[u] = mSearchStamp;
+				mvSearchCost[u] = cost;
+				mvSearchPredecessor[u] = top.vertex;
+				SpurEntry entry = {cost, true, u, top.vertex};
+				candidates.push(entry);
+			}
+			else if (mvTreeDistance[u] < Graph::DISCONNECT)
+			{
+				SpurEntry entry = {cost + mvTreeDistance[u], false, u, top.vertex};
+				candidates.push(entry);
+			}
+		}
+	}
+	return false;
+}
+
+BasePath *Feng::makePath(const std::vector<int> &path, double cost) const
+{
+	std::vector<BaseVertex *> vertex_list;
+	for (size_t i = 0; i < path.size(); ++i)
+	{
+		vertex_list.push_back(mFlatGraph.getVertex(path[i]));
+	}
+	return new Path(vertex_list, cost);
+}
+
+bool Feng::hasNext()
+{
+	return !mqPathCandidates.empty();
+}
+
+BasePath *Feng::next()
+{
+	if (mqPathCandidates.empty())
+	{
+		return NULL;
+	}
+	BasePath *cur_path = *(mqPathCandidates.begin());
+	mqPathCandidates.erase(mqPathCandidates.begin());
+	mvResultList.push_back(cur_path);
+	int deviation_index = mmDeviationIndex.find(cur_path)->second;
+	int path_length = cur_path->length();
+	std::vector<int> cur_indices(path_length);
+	std::vector<double> costs(path_length, 0);
+	for (int i = 0; i < path_length; ++i)
+	{
+		cur_indices[i] = cur_path->getVertex(i)->getIndex();
+	}
+	for (int i = 1; i < path_length; ++i)
+	{
+		costs[i] = costs[i - 1] + mGraph.getOriginalEdgeWeight(cur_path->getVertex(i - 1), cur_path->getVertex(i));
+	}
+	std::vector<int> prefix_nodes(path_length);
+	for (int i = 0, node = 0; i < path_length; ++i)
+	{
+		std::map<int, int>::iterator pos = mvResultPrefixTree[node].find(cur_indices[i]);
+		if (pos == mvResultPrefixTree[node].end())
+		{
+			pos = mvResultPrefixTree[node].insert(std::make_pair(cur_indices[i], (int)mvResultPrefixTree.size())).first;
+			mvResultPrefixTree.push_back(std::map<int, int>());
+		}
+		node = prefix_nodes[i] = pos->second;
+	}
+	if (mRemainingPathNum > 0 && --mRemainingPathNum == 0)
+	{
+		return cur_path;
+	}
+
+	// the root path before the deviation vertex is red for all the spurs
+	++mColorStamp;
+	for (int i = 0; i < deviation_index; ++i)
+	{
+		markRed(cur_indices[i]);
+	}
+
+	std::vector<std::pair<BasePath *, int>> new_candidates;
+	std::vector<int> spur_path;
+	double spur_cost;
+	for (int i = deviation_index; i < path_length - 1; ++i)
+	{
+		markRed(cur_indices[i]);
+		// the next vertices of the results sharing the root path are blocked from the spur vertex
+		std::vector<int> blocked_successors;
+		const std::map<int, int> &successors = mvResultPrefixTree[prefix_nodes[i]];
+		for (std::map<int, int>::const_iterator pos = successors.begin(); pos != successors.end(); ++pos)
+		{
+			blocked_successors.push_back(pos->first);
+		}
+		if (searchSpur(cur_indices[i], blocked_successors, spur_path, spur_cost))
+		{
+			++mGeneratedPathNum;
+			std::vector<int> candidate_indices(cur_indices.begin(), cur_indices.begin() + i);
+			candidate_indices.insert(candidate_indices.end(), spur_path.begin(), spur_path.end());
+			new_candidates.push_back(std::make_pair(makePath(candidate_indices, costs[i] + spur_cost), i));
+		}
+	}
+
+	// queued from the end of the path as Yen does, so that equal-cost candidates come out in the same order
+	for (int i = (int)new_candidates.size() - 1; i >= 0; --i)
+	{
+		mqPathCandidates.insert(new_candidates[i].first);
+		mmDeviationIndex[new_candidates[i].first] = new_candidates[i].second;
+	}
+	// the last of equal-cost candidates is the last queued, as Yen would return it last
+	while (mRemainingPathNum > 0 && (int)mqPathCandidates.size() > mRemainingPathNum)
+	{
+		std::multiset<BasePath *, WeightLess<BasePath>>::iterator pos = --mqPathCandidates.end();
+		mmDeviationIndex.erase(*pos);
+		delete *pos;
+		mqPathCandidates.erase(pos);
+	}
+	return cur_path;
+}
+
+void Feng::getShortestPaths(BaseVertex *pSource, BaseVertex *pTarget, int top_k, std::vector<BasePath *> &result_list)
+{
+	mpSourceVertex = pSource;
+	mpTargetVertex = pTarget;
+	initialize();
+	mRemainingPathNum = top_k;
+	int count = 0;
+	while (hasNext() && count < top_k)
+	{
+		next();
+		++count;
+	}
+	result_list.assign(mvResultList.begin(), mvResultList.end());
+}
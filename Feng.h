@@ -0,0 +1,74 @@
+#ifndef __FENG_H__
+#define __FENG_H__
+
+/* Feng's node classification algorithm for the top k shortest paths connecting a pair of vertices,
+giving the same paths as Yen's algorithm (up to the order of equal-cost paths).
+The reverse shortest path tree of the target is built once per query. For a spur vertex, the vertices of the root path
+up to it are red; the vertices whose tree path to the target goes through a red vertex are yellow, the others green:
+the tree distance of a green vertex still holds without the red ones. The spur search only settles yellow vertices and
+stops at the first green exit, i.e. a green vertex reached with the least cost plus tree distance, so that most spurs
+are answered from the tree. The yellow vertices are kept up to date as the spur vertex moves along a path,
+by marking the tree subtree of each new red vertex.
+It works on a snapshot of the graph, so that several queries can share one graph from parallel threads.
+The returned paths belong to the object and live until clear() or its destruction. */
+class Feng
+{
+public:
+	Feng(Graph &graph) : Feng(graph, NULL, NULL) {}
+	Feng(Graph &graph, BaseVertex* pSource, BaseVertex* pTarget);
+	~Feng(void);
+
+	bool 		hasNext();
+	BasePath*	next();
+	BasePath*	getShortestPath(BaseVertex* pSource, BaseVertex* pTarget);
+	/* Knowing k, the candidates beyond the paths still to return are dropped: the object is done with the query afterwards */
+	void 		getShortestPaths(BaseVertex* pSource, BaseVertex* pTarget, int top_k, std::vector<BasePath*>&);
+	void 		clear();
+
+	/* Spur paths found, spurs answered without settling a yellow vertex, and yellow vertices settled, since the query started */
+	int 		getGeneratedPathNum() const 		{ return mGeneratedPathNum; }
+	int 		getTreeSpurNum() const 				{ return mTreeSpurNum; }
+	long long 	getYellowSettledNum() const 		{ return mYellowSettledNum; }
+
+protected:
+	void 		buildTree();
+	void 		markRed(int vertex);
+	bool 		searchSpur(int spur, const std::vector<int> &blocked_successors, std::vector<int> &spur_path, double &spur_cost);
+	BasePath*	makePath(const std::vector<int> &path, double cost) const;
+
+private:
+	Graph& 											mGraph;
+	FlatGraph 										mFlatGraph;
+	BaseVertex*										mpSourceVertex;
+	BaseVertex*										mpTargetVertex;
+
+	// reverse shortest path tree of the target, with the children of every vertex in compressed rows
+	std::vector<double> 							mvTreeDistance;
+	std::vector<int> 								mvTreeSuccessor;
+	std::vector<int> 								mvChildOffsets;
+	std::vector<int> 								mvChildren;
+
+	// vertex colors of the current path, and labels of the current spur search, valid with the current stamps
+	std::vector<int> 								mvRedStamp;
+	std::vector<int> 								mvYellowStamp;
+	int 											mColorStamp;
+	std::vector<int> 								mvSearchStamp;
+	std::vector<double> 							mvSearchCost;
+	std::vector<int> 								mvSearchPredecessor;
+	int 											mSearchStamp;
+
+	std::vector<BasePath*> 							mvResultList;
+	// prefix tree of the results: the next vertices from a root path are the children of its node, node 0 being the empty path
+	std::vector<std::map<int, int>> 				mvResultPrefixTree;
+	std::map<BasePath*, int> 						mmDeviationIndex;
+	std::multiset<BasePath*, WeightLess<BasePath>> 	mqPathCandidates;
+	int 											mRemainingPathNum;
+
+	int 											mGeneratedPathNum;
+	int 											mTreeSpurNum;
+	long long 										mYellowSettledNum;
+
+	void initialize();
+};
+
+#endif // __FENG_H__
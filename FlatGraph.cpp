@@ -0,0 +1,48 @@
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "FlatGraph.h"
+
+FlatGraph::FlatGraph(Graph &graph)
+{
+	mvVertices.assign(graph.getVertexList().begin(), graph.getVertexList().end());
+	mVertexNum = mvVertices.size();
+	mvOutOffsets.assign(mVertexNum + 1, 0);
+	mvInOffsets.assign(mVertexNum + 1, 0);
+
+	// fan-out edges, in the order of the vertex storage
+	for (int v = 0; v < mVertexNum; ++v)
+	{
+		std::set<BaseVertex *> adj_vertex_set;
+		graph.getAdjacentVertices(mvVertices[v], adj_vertex_set);
+		for (std::set<BaseVertex *>::const_iterator pos = adj_vertex_set.begin(); pos != adj_vertex_set.end(); ++pos)
+		{
+			mvOutTargets.push_back((*pos)->getIndex());
+			mvOutWeights.push_back(graph.getEdgeWeight(mvVertices[v], *pos));
+			++mvInOffsets[(*pos)->getIndex() + 1];
+		}
+		mvOutOffsets[v + 1] = mvOutTargets.size();
+	}
+	mEdgeNum = mvOutTargets.size();
+
+	// fan-in edges are the transposition of the fan-out ones
+	for (int v = 0; v < mVertexNum; ++v)
+	{
+		mvInOffsets[v + 1] += mvInOffsets[v];
+	}
+	mvInSources.resize(mEdgeNum);
+	mvInWeights.resize(mEdgeNum);
+	std::vector<int> fill_pos(mvInOffsets.begin(), mvInOffsets.end() - 1);
+	for (int v = 0; v < mVertexNum; ++v)
+	{
+		for (int e = mvOutOffsets[v]; e < mvOutOffsets[v + 1]; ++e)
+		{
+			int slot = fill_pos[mvOutTargets[e]]++;
+			mvInSources[slot] = v;
+			mvInWeights[slot] = mvOutWeights[e];
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef __FLATGRAPH_H__
+#define __FLATGRAPH_H__
+
+/* Read-only snapshot of a graph in compressed sparse row form.
+Vertices are addressed by their dense index (BaseVertex::getIndex()), the fan-out and fan-in
+edges of each vertex are stored contiguously so that searches can scan them without map lookups.
+Removed vertices and edges of the source graph at snapshot time are left out. */
+class FlatGraph
+{
+public:
+	FlatGraph(Graph &graph);
+	~FlatGraph(void) {}
+
+	int 			getVertexNum() const 					{ return mVertexNum; }
+	int 			getEdgeNum() const 						{ return mEdgeNum; }
+	BaseVertex*		getVertex(int index) const 				{ return mvVertices[index]; }
+	/* Fan-out edges of vertex v are [outBegin(v), outEnd(v)) */
+	int 			outBegin(int v) const 					{ return mvOutOffsets[v]; }
+	int 			outEnd(int v) const 					{ return mvOutOffsets[v + 1]; }
+	int 			outTarget(int e) const 					{ return mvOutTargets[e]; }
+	double 			outWeight(int e) const 					{ return mvOutWeights[e]; }
+	/* Fan-in edges of vertex v are [inBegin(v), inEnd(v)) */
+	int 			inBegin(int v) const 					{ return mvInOffsets[v]; }
+	int 			inEnd(int v) const 						{ return mvInOffsets[v + 1]; }
+	int 			inSource(int e) const 					{ return mvInSources[e]; }
+	double 			inWeight(int e) const 					{ return mvInWeights[e]; }
+	/* The arrays themselves, for the loops that keep them in registers */
+	const int* 		getOutOffsets() const 					{ return mvOutOffsets.data(); }
+	const int* 		getOutTargets() const 					{ return mvOutTargets.data(); }
+	const int* 		getInOffsets() const 					{ return mvInOffsets.data(); }
+	const int* 		getInSources() const 					{ return mvInSources.data(); }
+
+private:
+	int 						mVertexNum;
+	int 						mEdgeNum;
+	std::vector<BaseVertex*> 	mvVertices;
+	std::vector<int> 			mvOutOffsets;
+	std::vector<int> 			mvOutTargets;
+	std::vector<double> 		mvOutWeights;
+	std::vector<int> 			mvInOffsets;
+	std::vector<int> 			mvInSources;
+	std::vector<double> 		mvInWeights;
+};
+
+#endif // __FLATGRAPH_H__
@@ -1,3 +1,6 @@
+#include <cmath>
+#include <cstring>
+#include <queue>
 #include <limits>
 #include <set>
 #include <map>
@@ -8,23 +11,68 @@
 #include <algorithm>
 #include "BaseGraph.h"
 #include "Graph.h"
+#include "GraphImage.h"
+#include "Instrument.h"
 
 const double Graph::DISCONNECT = (std::numeric_limits<double>::max)();
 
-Graph::Graph(const std::string &file_name)
+/* Edge of the compact mode, by internal indices */
+struct Graph::CompactEdge
+{
+	unsigned int 	start;
+	unsigned int 	end;
+	float 			weight;
+};
+
+Graph::Graph(const std::string &file_name, double weight_unit, VertexOrder vertex_order, bool is_compact) : mVertexOrder(vertex_order), mWeightUnit(weight_unit), mMaxIntEdgeWeight(0), mIsCompact(is_compact), mpImage(NULL), mpOriginal(NULL)
 {
 	importFromFile(file_name);
+	reorderVertices(vertex_order);
+}
+
+Graph::Graph(const GraphImage &image) : mVertexOrder(ORDER_FIRST_SEEN), mWeightUnit(0), mMaxIntEdgeWeight(0), mIsCompact(true), mpImage(NULL), mpOriginal(NULL)
+{
+	clear();
+	mVertexNum = image.getVertexNum();
+	mEdgeNum = image.getEdgeNum();
+	mWeightUnit = image.getWeightUnit();
+	mMaxIntEdgeWeight = image.getMaxIntEdgeWeight();
+	mVertexOrder = (VertexOrder)image.getVertexOrder();
+	mpImage = &image;
+
+	// the vertices keep the indices of the image
+	const int *vertex_ids = image.getVertexIds();
+	mvVertexBlock.resize(mVertexNum);
+	mvVertices.resize(mVertexNum);
+	mvVertexIdIndex.resize(mVertexNum);
+	for (int v = 0; v < mVertexNum; ++v)
+	{
+		mvVertexBlock[v].setID(vertex_ids[v]);
+		mvVertexBlock[v].setIndex(v);
+		mvVertices[v] = &mvVertexBlock[v];
+		mvVertexIdIndex[v] = std::make_pair(vertex_ids[v], mvVertices[v]);
+	}
+	std::sort(mvVertexIdIndex.begin(), mvVertexIdIndex.end());
+	pointToCompactArrays();
 }
 
 Graph::Graph(const Graph &graph)
 {
 	mVertexNum = graph.mVertexNum;
 	mEdgeNum = graph.mEdgeNum;
-	mvVertices.assign(graph.mvVertices.begin(), graph.mvVertices.end());
-	mmFaninVertices.insert(graph.mmFaninVertices.begin(), graph.mmFaninVertices.end());
-	mmFanoutVertices.insert(graph.mmFanoutVertices.begin(), graph.mmFanoutVertices.end());
-	mmEdgeCodeWeight.insert(graph.mmEdgeCodeWeight.begin(), graph.mmEdgeCodeWeight.end());
-	mmVertexIndex.insert(graph.mmVertexIndex.begin(), graph.mmVertexIndex.end());
+	mVertexOrder = graph.mVertexOrder;
+	mWeightUnit = graph.mWeightUnit;
+	mMaxIntEdgeWeight = graph.mMaxIntEdgeWeight;
+	mIsCompact = graph.mIsCompact;
+	mpImage = graph.mpImage;
+	// a copy of a copy reads the same original: nothing of the graph data is copied, a query holds its removed sets only
+	mpOriginal = graph.mpOriginal != NULL ? graph.mpOriginal : &graph;
+	// the packed arrays are read in place, as the ones of a mapped image
+	mpFanoutOffsets = graph.mpFanoutOffsets;
+	mpFanoutTargets = graph.mpFanoutTargets;
+	mpFanoutWeights = graph.mpFanoutWeights;
+	mpFaninOffsets = graph.mpFaninOffsets;
+	mpFaninSources = graph.mpFaninSources;
 }
 
 Graph::~Graph(void)
@@ -36,9 +84,12 @@ Graph::~Graph(void)
 The format of the file is as follows:
 	1. The first line has an integer as the number of vertices of the graph
 	2. Each line afterwards contains a directed edge in the graph: starting point, ending point and the weight of the edge.
-	These values are separated by 'white space'. */
+	These values are separated by 'white space'.
+In the integer weight mode, the weights are rounded to the nearest multiple of the weight unit.
+In the compact mode, the edges are gathered in a list and packed once the file is read. */
 void Graph::importFromFile(const std::string &input_file_name)
 {
+	INSTRUMENT_SCOPE(GRAPH_IMPORT);
 	const char *file_name = input_file_name.c_str();
 
 	// check the validity of the file
@@ -56,6 +107,10 @@ void Graph::importFromFile(const std::string &input_file_name)
 	/// note the format of the data in the graph file.
 	// the first line has an integer as the number of vertices of the graph
 	ifs >> mVertexNum;
+	if (mIsCompact && mVertexNum > 0)
+	{
+		mvVertexBlock.reserve(mVertexNum);
+	}
 
 	// in the following lines, each line contains a directed edge in the graph:
 	/// the id of starting point, the id of ending point, the weight of the edge.
@@ -63,6 +118,7 @@ void Graph::importFromFile(const std::string &input_file_name)
 	int start_vertex, end_vertex;
 	double edge_weight;
 	int vertex_id = 0;
+	std::vector<CompactEdge> compact_edges;
 
 	while (ifs >> start_vertex)
 	{
@@ -72,11 +128,24 @@ void Graph::importFromFile(const std::string &input_file_name)
 		}
 		ifs >> end_vertex;
 		ifs >> edge_weight;
+		if (isQuantized())
+		{
+			long long int_weight = llround(edge_weight / mWeightUnit);
+			mMaxIntEdgeWeight = std::max(mMaxIntEdgeWeight, int_weight);
+			edge_weight = int_weight * mWeightUnit;
+		}
 
 		/// construct the vertices
 		BaseVertex *start_vertex_pt = getVertex(start_vertex);
 		BaseVertex *end_vertex_pt = getVertex(end_vertex);
 
+		if (mIsCompact)
+		{
+			CompactEdge edge = {(unsigned int)start_vertex_pt->getIndex(), (unsigned int)end_vertex_pt->getIndex(), (float)edge_weight};
+			compact_edges.push_back(edge);
+			continue;
+		}
+
 		/// add the edge weight
 		//// note that the duplicate edge would overwrite the one occurring before.
 		mmEdgeCodeWeight[getEdgeCode(start_vertex_pt, end_vertex_pt)] = edge_weight;
@@ -95,10 +164,358 @@ void Graph::importFromFile(const std::string &input_file_name)
 		exit(1);
 	}
 	mVertexNum = mvVertices.size();
-	mEdgeNum = mmEdgeCodeWeight.size();
+	if (mIsCompact)
+	{
+		buildCompactArrays(compact_edges);
+		mvVertexIdIndex.assign(mmVertexIndex.begin(), mmVertexIndex.end());
+		mmVertexIndex.clear();
+	}
+	mEdgeNum = mIsCompact ? mvFanoutTargets.size() : mmEdgeCodeWeight.size();
 	ifs.close();
 }
 
+/* Pack the edges of the compact mode. As in the maps, a duplicate edge keeps the last weight read. */
+void Graph::buildCompactArrays(std::vector<CompactEdge> &edges)
+{
+	std::stable_sort(edges.begin(), edges.end(), [](const CompactEdge &a, const CompactEdge &b) { return a.start < b.start || (a.start == b.start && a.end < b.end); });
+	size_t edge_num = 0;
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		if (edge_num > 0 && edges[edge_num - 1].start == edges[i].start && edges[edge_num - 1].end == edges[i].end)
+		{
+			edges[edge_num - 1] = edges[i];
+		}
+		else
+		{
+			edges[edge_num++] = edges[i];
+		}
+	}
+	edges.resize(edge_num);
+	if (edge_num >= (std::numeric_limits<unsigned int>::max)())
+	{
+		std::cerr << "The graph has too many edges for the compact mode: " << edge_num << std::endl;
+		exit(1);
+	}
+
+	size_t vertex_num = mvVertices.size();
+	mvFanoutOffsets.assign(vertex_num + 1, 0);
+	mvFaninOffsets.assign(vertex_num + 1, 0);
+	mvFanoutTargets.resize(edge_num);
+	mvFanoutWeights.resize(edge_num);
+	mvFaninSources.resize(edge_num);
+	for (size_t e = 0; e < edge_num; ++e)
+	{
+		mvFanoutTargets[e] = edges[e].end;
+		mvFanoutWeights[e] = edges[e].weight;
+		++mvFanoutOffsets[edges[e].start + 1];
+		++mvFaninOffsets[edges[e].end + 1];
+	}
+	for (size_t v = 0; v < vertex_num; ++v)
+	{
+		mvFanoutOffsets[v + 1] += mvFanoutOffsets[v];
+		mvFaninOffsets[v + 1] += mvFaninOffsets[v];
+	}
+
+	// the edges come by increasing start, so every fan-in list is sorted by source as well
+	std::vector<unsigned int> fill_pos(mvFaninOffsets.begin(), mvFaninOffsets.end() - 1);
+	for (size_t e = 0; e < edge_num; ++e)
+	{
+		mvFaninSources[fill_pos[edges[e].end]++] = edges[e].start;
+	}
+	pointToCompactArrays();
+}
+
+/* The vectors of the compact mode, or the arrays of the image for the ones left empty by a graph on an image */
+void Graph::pointToCompactArrays()
+{
+	bool is_own = mpImage == NULL;
+	mpFanoutOffsets = is_own || !mvFanoutOffsets.empty() ? mvFanoutOffsets.data() : mpImage->getFanoutOffsets();
+	mpFanoutTargets = is_own ? mvFanoutTargets.data() : mpImage->getFanoutTargets();
+	mpFanoutWeights = is_own ? mvFanoutWeights.data() : mpImage->getFanoutWeights();
+	mpFaninOffsets = is_own || !mvFaninOffsets.empty() ? mvFaninOffsets.data() : mpImage->getFaninOffsets();
+	mpFaninSources = is_own ? mvFaninSources.data() : mpImage->getFaninSources();
+}
+
+void Graph::saveImage(const std::string &file_name) const
+{
+	if (!mIsCompact || mpFanoutOffsets == NULL)
+	{
+		std::cerr << "Only a graph in the compact mode has an image." << std::endl;
+		exit(1);
+	}
+	std::ofstream ofs(file_name.c_str(), std::ios::binary | std::ios::trunc);
+	if (!ofs)
+	{
+		std::cerr << "The file " << file_name << " can not be opened!" << std::endl;
+		exit(1);
+	}
+	int vertex_num = getOriginal().mvVertices.size();
+	std::vector<size_t> positions;
+	size_t byte_num = 0;
+	GraphImage::getLayout(vertex_num, mEdgeNum, positions, byte_num);
+
+	GraphImage::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "DSCGRAPH", sizeof(header.magic));
+	header.version = GraphImage::VERSION;
+	header.vertex_num = vertex_num;
+	header.edge_num = mEdgeNum;
+	header.weight_unit = mWeightUnit;
+	header.max_int_edge_weight = mMaxIntEdgeWeight;
+	header.vertex_order = mVertexOrder;
+
+	std::vector<int> vertex_ids(vertex_num);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		vertex_ids[v] = getOriginal().mvVertices[v]->getID();
+	}
+	const char *arrays[6] = {(const char *)vertex_ids.data(), (const char *)mpFanoutOffsets, (const char *)mpFanoutTargets,
+							 (const char *)mpFanoutWeights, (const char *)mpFaninOffsets, (const char *)mpFaninSources};
+	size_t sizes[6] = {vertex_num * sizeof(int), (vertex_num + 1) * sizeof(unsigned int), mEdgeNum * sizeof(unsigned int),
+					   mEdgeNum * sizeof(float), (vertex_num + 1) * sizeof(unsigned int), mEdgeNum * sizeof(unsigned int)};
+
+	// every array at its position, the gaps filled with zeros
+	std::vector<char> padding(8, 0);
+	ofs.write((const char *)&header, sizeof(header));
+	size_t written = sizeof(header);
+	for (int i = 0; i < 6; ++i)
+	{
+		ofs.write(padding.data(), positions[i] - written);
+		ofs.write(arrays[i], sizes[i]);
+		written = positions[i] + sizes[i];
+	}
+	ofs.write(padding.data(), byte_num - written);
+	if (!ofs)
+	{
+		std::cerr << "The image " << file_name << " can not be written." << std::endl;
+		exit(1);
+	}
+}
+
+/* BFS from start over the undirected neighborhoods, return the vertex of smallest degree in the deepest level */
+static int farthestVertex(const std::vector<std::vector<int>> &neighbors, int start, int stamp, std::vector<int> &visit_stamps, std::vector<int> &levels, int &depth)
+{
+	std::queue<int> vertex_queue;
+	vertex_queue.push(start);
+	visit_stamps[start] = stamp;
+	levels[start] = 0;
+	int farthest = start;
+	depth = 0;
+	while (!vertex_queue.empty())
+	{
+		int v = vertex_queue.front();
+		vertex_queue.pop();
+		if (levels[v] > depth || (levels[v] == depth && neighbors[v].size() < neighbors[farthest].size()))
+		{
+			depth = levels[v];
+			farthest = v;
+		}
+		for (size_t i = 0; i < neighbors[v].size(); ++i)
+		{
+			int u = neighbors[v][i];
+			if (visit_stamps[u] != stamp)
+			{
+				visit_stamps[u] = stamp;
+				levels[u] = levels[v] + 1;
+				vertex_queue.push(u);
+			}
+		}
+	}
+	return farthest;
+}
+
+/* Breadth-first order of the vertices, component by component, each one from a pseudo-peripheral vertex.
+With is_by_degree, the neighbors are visited by increasing degree and the order is reversed (reverse Cuthill-McKee). */
+static void breadthFirstOrder(const std::vector<std::vector<int>> &neighbors, bool is_by_degree, std::vector<int> &order)
+{
+	int vertex_num = neighbors.size();
+	std::vector<int> visit_stamps(vertex_num, -1);
+	std::vector<char> is_ordered(vertex_num, 0);
+	int stamp = 0;
+	std::vector<int> levels(vertex_num, 0);
+	order.clear();
+
+	// vertices by increasing degree, to pick the start of every component
+	std::vector<int> by_degree(vertex_num);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		by_degree[v] = v;
+	}
+	std::stable_sort(by_degree.begin(), by_degree.end(), [&](int a, int b) { return neighbors[a].size() < neighbors[b].size(); });
+
+	std::vector<int> sorted_neighbors;
+	for (int i = 0; i < vertex_num; ++i)
+	{
+		int start = by_degree[i];
+		if (is_ordered[start])
+		{
+			continue;
+		}
+
+		// move to a pseudo-peripheral vertex while the eccentricity grows (George-Liu)
+		int depth = 0;
+		start = farthestVertex(neighbors, start, stamp++, visit_stamps, levels, depth);
+		for (int round = 0; round < 5; ++round)
+		{
+			int new_depth = 0;
+			int farthest = farthestVertex(neighbors, start, stamp++, visit_stamps, levels, new_depth);
+			if (new_depth <= depth)
+			{
+				break;
+			}
+			start = farthest;
+			depth = new_depth;
+		}
+
+		std::queue<int> vertex_queue;
+		vertex_queue.push(start);
+		is_ordered[start] = 1;
+		while (!vertex_queue.empty())
+		{
+			int v = vertex_queue.front();
+			vertex_queue.pop();
+			order.push_back(v);
+			sorted_neighbors.assign(neighbors[v].begin(), neighbors[v].end());
+			if (is_by_degree)
+			{
+				std::stable_sort(sorted_neighbors.begin(), sorted_neighbors.end(), [&](int a, int b) { return neighbors[a].size() < neighbors[b].size(); });
+			}
+			for (size_t j = 0; j < sorted_neighbors.size(); ++j)
+			{
+				if (!is_ordered[sorted_neighbors[j]])
+				{
+					is_ordered[sorted_neighbors[j]] = 1;
+					vertex_queue.push(sorted_neighbors[j]);
+				}
+			}
+		}
+	}
+	if (is_by_degree)
+	{
+		std::reverse(order.begin(), order.end());
+	}
+}
+
+/* Renumber the internal indices so that the vertices linked by an edge get close indices.
+The external IDs do not change. The vertex objects move to one block in the new order, so that Dijkstra and Yen,
+which go through the vertex pointers, find the neighbors close in memory as well; the structures keyed by the vertices,
+the edge codes and the packed arrays are rebuilt on the block. */
+void Graph::reorderVertices(VertexOrder vertex_order)
+{
+	if (vertex_order == ORDER_FIRST_SEEN || mvVertices.empty())
+	{
+		return;
+	}
+
+	// undirected neighborhood of every vertex, and the edges by index
+	int vertex_num = mvVertices.size();
+	std::vector<std::vector<int>> neighbors(vertex_num);
+	std::vector<std::pair<std::pair<int, int>, double>> edges;
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		std::set<BaseVertex *> adj_vertex_set;
+		getAdjacentVertices(mvVertices[v], adj_vertex_set);
+		for (VertexPtSetIterator end_pos = adj_vertex_set.begin(); end_pos != adj_vertex_set.end(); ++end_pos)
+		{
+			neighbors[v].push_back((*end_pos)->getIndex());
+			neighbors[(*end_pos)->getIndex()].push_back(v);
+			edges.push_back(std::make_pair(std::make_pair(v, (*end_pos)->getIndex()), getOriginalEdgeWeight(mvVertices[v], *end_pos)));
+		}
+	}
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		std::sort(neighbors[v].begin(), neighbors[v].end());
+		neighbors[v].erase(std::unique(neighbors[v].begin(), neighbors[v].end()), neighbors[v].end());
+	}
+
+	std::vector<int> order;
+	breadthFirstOrder(neighbors, vertex_order == ORDER_RCM, order);
+	std::vector<int> new_indices(vertex_num);
+	std::vector<BaseVertex> vertex_block(vertex_num);
+	for (int i = 0; i < vertex_num; ++i)
+	{
+		new_indices[order[i]] = i;
+		vertex_block[i].setID(mvVertices[order[i]]->getID());
+		vertex_block[i].setIndex(i);
+	}
+
+	// drop the structures on the old vertices, then the old vertices but the ones of the block
+	for (BaseVertexPt2SetMapIterator pos = mmFaninVertices.begin(); pos != mmFaninVertices.end(); ++pos)
+	{
+		delete pos->second;
+	}
+	for (BaseVertexPt2SetMapIterator pos = mmFanoutVertices.begin(); pos != mmFanoutVertices.end(); ++pos)
+	{
+		delete pos->second;
+	}
+	mmFaninVertices.clear();
+	mmFanoutVertices.clear();
+	mmEdgeCodeWeight.clear();
+	mmVertexIndex.clear();
+	mvVertexIdIndex.clear();
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		if (mvVertexBlock.empty() || mvVertices[v] < &mvVertexBlock.front() || mvVertices[v] > &mvVertexBlock.back())
+		{
+			delete mvVertices[v];
+		}
+	}
+	mvVertexBlock.swap(vertex_block);
+	for (int i = 0; i < vertex_num; ++i)
+	{
+		mvVertices[i] = &mvVertexBlock[i];
+	}
+
+	if (mIsCompact)
+	{
+		for (int i = 0; i < vertex_num; ++i)
+		{
+			mvVertexIdIndex.push_back(std::make_pair(mvVertices[i]->getID(), mvVertices[i]));
+		}
+		std::sort(mvVertexIdIndex.begin(), mvVertexIdIndex.end());
+		std::vector<CompactEdge> compact_edges(edges.size());
+		for (size_t i = 0; i < edges.size(); ++i)
+		{
+			CompactEdge edge = {(unsigned int)new_indices[edges[i].first.first], (unsigned int)new_indices[edges[i].first.second], (float)edges[i].second};
+			compact_edges[i] = edge;
+		}
+		buildCompactArrays(compact_edges);
+		return;
+	}
+	for (int i = 0; i < vertex_num; ++i)
+	{
+		mmVertexIndex[mvVertices[i]->getID()] = mvVertices[i];
+	}
+	// the sets and the map nodes are allocated in the new order as well
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		BaseVertex *start_vertex_pt = mvVertices[new_indices[edges[i].first.first]];
+		BaseVertex *end_vertex_pt = mvVertices[new_indices[edges[i].first.second]];
+		mmEdgeCodeWeight[getEdgeCode(start_vertex_pt, end_vertex_pt)] = edges[i].second;
+		getVertexSetPt(end_vertex_pt, mmFaninVertices)->insert(start_vertex_pt);
+		getVertexSetPt(start_vertex_pt, mmFanoutVertices)->insert(end_vertex_pt);
+	}
+}
+
+/* Search the ID index, i.e. the map, or the sorted pairs of the compact mode once imported */
+BaseVertex *Graph::findVertex(int node_id) const
+{
+	const Graph &original = getOriginal();
+	if (mIsCompact && mpFanoutOffsets != NULL)
+	{
+		std::vector<std::pair<int, BaseVertex *>>::const_iterator pos = std::lower_bound(original.mvVertexIdIndex.begin(), original.mvVertexIdIndex.end(), std::make_pair(node_id, (BaseVertex *)NULL));
+		return pos != original.mvVertexIdIndex.end() && pos->first == node_id ? pos->second : NULL;
+	}
+	std::map<int, BaseVertex *>::const_iterator pos = original.mmVertexIndex.find(node_id);
+	return pos == original.mmVertexIndex.end() ? NULL : pos->second;
+}
+
+int Graph::getInternalIndex(int node_id) const
+{
+	BaseVertex *vertex_pt = findVertex(node_id);
+	return vertex_pt == NULL ? -1 : vertex_pt->getIndex();
+}
+
 BaseVertex *Graph::getVertex(int node_id)
 {
 	if (msRemovedVertexIds.find(node_id) != msRemovedVertexIds.end())
@@ -107,19 +524,43 @@ BaseVertex *Graph::getVertex(int node_id)
 	}
 	else
 	{
-		BaseVertex *vertex_pt = NULL;
-		const std::map<int, BaseVertex *>::iterator pos = mmVertexIndex.find(node_id);
-		if (pos == mmVertexIndex.end())
+		BaseVertex *vertex_pt = findVertex(node_id);
+		// the vertices belong to the original of a copy, which adds none
+		if (vertex_pt == NULL && mpOriginal == NULL)
 		{
 			int vertex_id = mvVertices.size();
-			vertex_pt = new BaseVertex();
+			// the block never grows past its reserved size, which keeps the pointers valid
+			if (mvVertexBlock.size() < mvVertexBlock.capacity())
+			{
+				mvVertexBlock.push_back(BaseVertex());
+				vertex_pt = &mvVertexBlock.back();
+			}
+			else
+			{
+				vertex_pt = new BaseVertex();
+			}
 			vertex_pt->setID(node_id);
-			mmVertexIndex[node_id] = vertex_pt;
+			vertex_pt->setIndex(vertex_id);
 			mvVertices.push_back(vertex_pt);
-		}
-		else
-		{
-			vertex_pt = pos->second;
+			if (mIsCompact && mpFanoutOffsets != NULL)
+			{
+				// a vertex unknown to the file: no edge
+				mvVertexIdIndex.insert(std::lower_bound(mvVertexIdIndex.begin(), mvVertexIdIndex.end(), std::make_pair(node_id, vertex_pt)), std::make_pair(node_id, vertex_pt));
+				if (mvFanoutOffsets.empty())
+				{
+					// a graph on an image grows its own copy of the offsets, the edges stay shared
+					mvFanoutOffsets.assign(mpFanoutOffsets, mpFanoutOffsets + vertex_id + 1);
+					mvFaninOffsets.assign(mpFaninOffsets, mpFaninOffsets + vertex_id + 1);
+				}
+				mvFanoutOffsets.push_back(mvFanoutOffsets.back());
+				mvFaninOffsets.push_back(mvFaninOffsets.back());
+				mpFanoutOffsets = mvFanoutOffsets.data();
+				mpFaninOffsets = mvFaninOffsets.data();
+			}
+			else
+			{
+				mmVertexIndex[node_id] = vertex_pt;
+			}
 		}
 		return vertex_pt;
 	}
@@ -129,34 +570,55 @@ void Graph::clear()
 {
 	mEdgeNum = 0;
 	mVertexNum = 0;
+	mMaxIntEdgeWeight = 0;
 
-	for (std::map<BaseVertex *, std::set<BaseVertex *> *>::const_iterator pos = mmFaninVertices.begin(); pos != mmFaninVertices.end(); ++pos)
+	// a copy leaves the shared sets and vertices to the original graph
+	if (mpOriginal == NULL)
 	{
-		delete pos->second;
+		for (std::map<BaseVertex *, std::set<BaseVertex *> *>::const_iterator pos = mmFaninVertices.begin(); pos != mmFaninVertices.end(); ++pos)
+		{
+			delete pos->second;
+		}
+		for (std::map<BaseVertex *, std::set<BaseVertex *> *>::const_iterator pos = mmFanoutVertices.begin(); pos != mmFanoutVertices.end(); ++pos)
+		{
+			delete pos->second;
+		}
 	}
 	mmFaninVertices.clear();
-
-	for (std::map<BaseVertex *, std::set<BaseVertex *> *>::const_iterator pos = mmFanoutVertices.begin(); pos != mmFanoutVertices.end(); ++pos)
-	{
-		delete pos->second;
-	}
 	mmFanoutVertices.clear();
 
 	mmEdgeCodeWeight.clear();
 
-	// clear the list of vertices objects
-	for_each(mvVertices.begin(), mvVertices.end(), DeleteFunc<BaseVertex>());
+	mvFanoutOffsets.clear();
+	mvFanoutTargets.clear();
+	mvFanoutWeights.clear();
+	mvFaninOffsets.clear();
+	mvFaninSources.clear();
+	mpImage = NULL;
+	mpFanoutOffsets = mpFanoutTargets = mpFaninOffsets = mpFaninSources = NULL;
+	mpFanoutWeights = NULL;
+
+	// clear the list of vertices objects, but the ones of the block
+	for (size_t i = 0; i < mvVertices.size() && mpOriginal == NULL; ++i)
+	{
+		if (mvVertexBlock.empty() || mvVertices[i] < &mvVertexBlock.front() || mvVertices[i] > &mvVertexBlock.back())
+		{
+			delete mvVertices[i];
+		}
+	}
 	mvVertices.clear();
+	std::vector<BaseVertex>().swap(mvVertexBlock);
 	mmVertexIndex.clear();
+	mvVertexIdIndex.clear();
 
 	msRemovedVertexIds.clear();
 	msRemovedEdge.clear();
 }
 
-int Graph::getEdgeCode(const BaseVertex *start_vertex_pt, const BaseVertex *end_vertex_pt) const
+long long Graph::getEdgeCode(const BaseVertex *start_vertex_pt, const BaseVertex *end_vertex_pt) const
 {
-	// the computation below works only if the result is smaller than the maximum of an integer
-	return start_vertex_pt->getID() * mVertexNum + end_vertex_pt->getID();
+	// dense indices keep the code unique whatever the vertex IDs are, 64 bits avoid overflowing on large graphs
+	return (long long)start_vertex_pt->getIndex() * mVertexNum + end_vertex_pt->getIndex();
 }
 
 std::set<BaseVertex *> *Graph::getVertexSetPt(BaseVertex *vertex_, std::map<BaseVertex *, std::set<BaseVertex *> *> &vertex_container_index)
@@ -185,12 +647,35 @@ double Graph::getEdgeWeight(const BaseVertex *source, const BaseVertex *sink)
 	}
 }
 
+/* Weight in number of weight units, -1 if disconnected. Only meaningful in the integer weight mode. */
+long long Graph::getIntEdgeWeight(const BaseVertex *source, const BaseVertex *sink)
+{
+	double weight = getEdgeWeight(source, sink);
+	return weight < DISCONNECT ? llround(weight / mWeightUnit) : -1;
+}
+
 void Graph::getAdjacentVertices(BaseVertex *vertex, std::set<BaseVertex *> &vertex_set)
 {
+	const Graph &original = getOriginal();
 	int starting_vt_id = vertex->getID();
-	if (msRemovedVertexIds.find(starting_vt_id) == msRemovedVertexIds.end())
+	if (mIsCompact && msRemovedVertexIds.find(starting_vt_id) == msRemovedVertexIds.end())
+	{
+		int v = vertex->getIndex();
+		for (unsigned int e = mpFanoutOffsets[v]; e < mpFanoutOffsets[v + 1]; ++e)
+		{
+			BaseVertex *ending_vt_pt = original.mvVertices[mpFanoutTargets[e]];
+			int ending_vt_id = ending_vt_pt->getID();
+			if (msRemovedVertexIds.find(ending_vt_id) != msRemovedVertexIds.end() || msRemovedEdge.find(std::make_pair(starting_vt_id, ending_vt_id)) != msRemovedEdge.end())
+			{
+				continue;
+			}
+			vertex_set.insert(ending_vt_pt);
+		}
+	}
+	else if (msRemovedVertexIds.find(starting_vt_id) == msRemovedVertexIds.end() && original.mmFanoutVertices.find(vertex) != original.mmFanoutVertices.end())
 	{
-		std::set<BaseVertex *> *vertex_pt_set = getVertexSetPt(vertex, mmFanoutVertices);
+		// no insertion for a vertex without fan-out: a query leaves the graph unchanged
+		std::set<BaseVertex *> *vertex_pt_set = original.mmFanoutVertices.find(vertex)->second;
 		for (std::set<BaseVertex *>::const_iterator pos = (*vertex_pt_set).begin(); pos != (*vertex_pt_set).end(); ++pos)
 		{
 			int ending_vt_id = (*pos)->getID();
@@ -205,10 +690,26 @@ void Graph::getAdjacentVertices(BaseVertex *vertex, std::set<BaseVertex *> &vert
 
 void Graph::getPrecedentVertices(BaseVertex *vertex, std::set<BaseVertex *> &vertex_set)
 {
-	if (msRemovedVertexIds.find(vertex->getID()) == msRemovedVertexIds.end())
+	const Graph &original = getOriginal();
+	if (mIsCompact && msRemovedVertexIds.find(vertex->getID()) == msRemovedVertexIds.end())
+	{
+		int ending_vt_id = vertex->getID();
+		int v = vertex->getIndex();
+		for (unsigned int e = mpFaninOffsets[v]; e < mpFaninOffsets[v + 1]; ++e)
+		{
+			BaseVertex *starting_vt_pt = original.mvVertices[mpFaninSources[e]];
+			int starting_vt_id = starting_vt_pt->getID();
+			if (msRemovedVertexIds.find(starting_vt_id) != msRemovedVertexIds.end() || msRemovedEdge.find(std::make_pair(starting_vt_id, ending_vt_id)) != msRemovedEdge.end())
+			{
+				continue;
+			}
+			vertex_set.insert(starting_vt_pt);
+		}
+	}
+	else if (msRemovedVertexIds.find(vertex->getID()) == msRemovedVertexIds.end() && original.mmFaninVertices.find(vertex) != original.mmFaninVertices.end())
 	{
 		int ending_vt_id = vertex->getID();
-		std::set<BaseVertex *> *pre_vertex_set = getVertexSetPt(vertex, mmFaninVertices);
+		std::set<BaseVertex *> *pre_vertex_set = original.mmFaninVertices.find(vertex)->second;
 		for (std::set<BaseVertex *>::const_iterator pos = (*pre_vertex_set).begin(); pos != (*pre_vertex_set).end(); ++pos)
 		{
 			int starting_vt_id = (*pos)->getID();
@@ -223,8 +724,16 @@ void Graph::getPrecedentVertices(BaseVertex *vertex, std::set<BaseVertex *> &ver
 
 double Graph::getOriginalEdgeWeight(const BaseVertex *source, const BaseVertex *sink)
 {
-	std::map<int, double>::const_iterator pos = mmEdgeCodeWeight.find(getEdgeCode(source, sink));
-	if (pos != mmEdgeCodeWeight.end())
+	if (mIsCompact)
+	{
+		const unsigned int *begin = mpFanoutTargets + mpFanoutOffsets[source->getIndex()];
+		const unsigned int *end = mpFanoutTargets + mpFanoutOffsets[source->getIndex() + 1];
+		const unsigned int *pos = std::lower_bound(begin, end, (unsigned int)sink->getIndex());
+		return pos != end && *pos == (unsigned int)sink->getIndex() ? mpFanoutWeights[pos - mpFanoutTargets] : DISCONNECT;
+	}
+	const std::map<long long, double> &edge_code_weight = getOriginal().mmEdgeCodeWeight;
+	std::map<long long, double>::const_iterator pos = edge_code_weight.find(getEdgeCode(source, sink));
+	if (pos != edge_code_weight.end())
 	{
 		return pos->second;
 	}
@@ -233,3 +742,69 @@ double Graph::getOriginalEdgeWeight(const BaseVertex *source, const BaseVertex *
 		return DISCONNECT;
 	}
 }
+
+/* Allocated size of a heap block of the given size, for glibc's malloc: 8 bytes of header, 16-byte alignment, 32 bytes at least */
+static size_t heapBlockBytes(size_t size)
+{
+	return std::max((size_t)32, (size + 8 + 15) & ~(size_t)15);
+}
+
+/* A node of the red-black trees of std::map and std::set: color, three links and the value */
+static size_t treeNodeBytes(size_t value_size)
+{
+	return heapBlockBytes(4 * sizeof(void *) + value_size);
+}
+
+template <class T>
+static size_t vectorBytes(const std::vector<T> &values)
+{
+	return values.capacity() * sizeof(T);
+}
+
+void Graph::getMemoryFootprint(std::vector<std::pair<std::string, size_t>> &footprint) const
+{
+	footprint.clear();
+	size_t single_vertex_num = mvVertices.size() - mvVertexBlock.size();
+	footprint.push_back(std::make_pair(std::string("vertices"), vectorBytes(mvVertices) + vectorBytes(mvVertexBlock) + single_vertex_num * heapBlockBytes(sizeof(BaseVertex))));
+	footprint.push_back(std::make_pair(std::string("vertex_index"), vectorBytes(mvVertexIdIndex) + mmVertexIndex.size() * treeNodeBytes(sizeof(std::pair<const int, BaseVertex *>))));
+	if (mIsCompact)
+	{
+		footprint.push_back(std::make_pair(std::string("fan_out"), vectorBytes(mvFanoutOffsets) + vectorBytes(mvFanoutTargets)));
+		footprint.push_back(std::make_pair(std::string("fan_in"), vectorBytes(mvFaninOffsets) + vectorBytes(mvFaninSources)));
+		footprint.push_back(std::make_pair(std::string("edge_weights"), vectorBytes(mvFanoutWeights)));
+	}
+	else
+	{
+		const std::map<BaseVertex *, std::set<BaseVertex *> *> *containers[2] = {&mmFanoutVertices, &mmFaninVertices};
+		const char *names[2] = {"fan_out", "fan_in"};
+		for (int i = 0; i < 2; ++i)
+		{
+			size_t bytes = 0;
+			for (std::map<BaseVertex *, std::set<BaseVertex *> *>::const_iterator pos = containers[i]->begin(); pos != containers[i]->end(); ++pos)
+			{
+				bytes += treeNodeBytes(sizeof(std::pair<BaseVertex *const, std::set<BaseVertex *> *>)) + heapBlockBytes(sizeof(std::set<BaseVertex *>));
+				bytes += pos->second->size() * treeNodeBytes(sizeof(BaseVertex *));
+			}
+			footprint.push_back(std::make_pair(std::string(names[i]), bytes));
+		}
+		footprint.push_back(std::make_pair(std::string("edge_weights"), mmEdgeCodeWeight.size() * treeNodeBytes(sizeof(std::pair<const long long, double>))));
+	}
+}
+
+void Graph::printMemoryFootprint(std::ostream &out_stream) const
+{
+	std::vector<std::pair<std::string, size_t>> footprint;
+	getMemoryFootprint(footprint);
+	size_t total = 0;
+	out_stream << "[MEMORY] " << (mIsCompact ? "compact" : "maps") << " mode, " << mVertexNum << " vertices, " << mEdgeNum << " edges" << std::endl;
+	for (size_t i = 0; i < footprint.size(); ++i)
+	{
+		out_stream << "  " << footprint[i].first << ": " << footprint[i].second << " bytes" << std::endl;
+		total += footprint[i].second;
+	}
+	out_stream << "  total: " << total << " bytes, " << (mEdgeNum > 0 ? (double)total / mEdgeNum : 0) << " per edge" << std::endl;
+	if (mpImage != NULL)
+	{
+		out_stream << "  mapped image, shared with the other processes: " << mpImage->getByteNum() << " bytes" << std::endl;
+	}
+}
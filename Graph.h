@@ -24,25 +24,51 @@ public:
 	}
 };
 
+class GraphImage;
+
 class Graph
 {
 public:
 	typedef std::set<BaseVertex*>::iterator 								VertexPtSetIterator;
 	typedef std::map<BaseVertex*, std::set<BaseVertex*>*>::iterator 		BaseVertexPt2SetMapIterator;
 	const static double 													DISCONNECT;
+	/* Storage order of the vertices, i.e. their internal indices (BaseVertex::getIndex()) and the vertex objects themselves:
+	as first seen in the file, breadth-first, or reverse Cuthill-McKee to keep the neighbors close in memory */
+	enum VertexOrder { ORDER_FIRST_SEEN, ORDER_BFS, ORDER_RCM };
 
-	Graph(const std::string &file_name);
+	/* A positive weight_unit turns on the integer weight mode: every weight is rounded to a multiple of the unit at import.
+	The compact mode keeps the edges in packed arrays with 32-bit indices and float weights instead of the maps. */
+	Graph(const std::string &file_name, double weight_unit = 0, VertexOrder vertex_order = ORDER_FIRST_SEEN, bool is_compact = false);
+	/* A compact graph on a mapped image, which must outlive it: the edge arrays are read in place */
+	Graph(const GraphImage &image);
+	/* The copy reads the vertices, the ID index and the edges of the original in place, which must outlive it and not change:
+	it holds its removed vertices and edges only, e.g. for one query of Yen's algorithm, and adds no vertex. */
 	Graph(const Graph &rGraph);
 	~Graph(void);
 
 	BaseVertex*					getVertex(int node_id);
-	int 						getEdgeCode(const BaseVertex* start_vertex_pt, const BaseVertex* end_vertex_pt) const;
+	long long 					getEdgeCode(const BaseVertex* start_vertex_pt, const BaseVertex* end_vertex_pt) const;
 	std::set<BaseVertex*>*		getVertexSetPt(BaseVertex* vertex_, std::map<BaseVertex*, std::set<BaseVertex*>*> &vertex_container_index);
 	double 						getOriginalEdgeWeight(const BaseVertex* source, const BaseVertex* sink);
 	double 						getEdgeWeight(const BaseVertex* source, const BaseVertex* sink);
+	long long 					getIntEdgeWeight(const BaseVertex* source, const BaseVertex* sink);
+	bool 						isQuantized() const 									{ return mWeightUnit > 0; }
+	double 						getWeightUnit() const 									{ return mWeightUnit; }
+	long long 					getMaxIntEdgeWeight() const 							{ return mMaxIntEdgeWeight; }
+	bool 						isCompact() const 										{ return mIsCompact; }
+	bool 						isMapped() const 										{ return mpImage != NULL; }
+	VertexOrder 				getVertexOrder() const 									{ return mVertexOrder; }
+	/* Write the binary image of a compact graph, see GraphImage */
+	void 						saveImage(const std::string &file_name) const;
 	void 						getAdjacentVertices(BaseVertex* vertex, std::set<BaseVertex*> &vertex_set);
 	void 						getPrecedentVertices(BaseVertex* vertex, std::set<BaseVertex*> &vertex_set);
 	void 						clear();
+	int 						getVertexNum() const 									{ return mVertexNum; }
+	int 						getEdgeNum() const 										{ return mEdgeNum; }
+	const std::vector<BaseVertex*>& getVertexList() const 								{ return getOriginal().mvVertices; }
+	/* External IDs are the ones of the graph file, internal indices the storage positions */
+	int 						getInternalIndex(int node_id) const;
+	int 						getExternalID(int index) const 							{ return getOriginal().mvVertices.at(index)->getID(); }
 	/* Graph modification */
 	void 						removeEdge(const std::pair<int, int> edge) 				{ msRemovedEdge.insert(edge); }
 	void 						removeVertex(const int vertex_id) 						{ msRemovedVertexIds.insert(vertex_id); }
@@ -50,22 +76,59 @@ public:
 	void 						recoverRemovedVertices() 								{ msRemovedVertexIds.clear(); }
 	void 						recoverRemovedEdge(const std::pair<int, int> edge) 		{ msRemovedEdge.erase(msRemovedEdge.find(edge)); }
 	void 						recoverRemovedVertex(int vertex_id) 					{ msRemovedVertexIds.erase(msRemovedVertexIds.find(vertex_id)); }
+	const std::set<int>& 		getRemovedVertexIds() const 							{ return msRemovedVertexIds; }
+	const std::set<std::pair<int, int>>& getRemovedEdges() const 						{ return msRemovedEdge; }
+	/* Estimated heap bytes of every structure (name, bytes) */
+	void 						getMemoryFootprint(std::vector<std::pair<std::string, size_t>> &footprint) const;
+	void 						printMemoryFootprint(std::ostream &out_stream) const;
 
 protected:
 	/* Basic information */
 	std::map<BaseVertex*, std::set<BaseVertex*>*> 		mmFanoutVertices;
 	std::map<BaseVertex*, std::set<BaseVertex*>*> 		mmFaninVertices;
-	std::map<int, double> 								mmEdgeCodeWeight;
+	std::map<long long, double> 						mmEdgeCodeWeight;
 	std::vector<BaseVertex*> 							mvVertices;
 	int 												mEdgeNum;
 	int 												mVertexNum;
 	std::map<int, BaseVertex*> 							mmVertexIndex;
+	VertexOrder 										mVertexOrder;
+	/* Integer weight mode */
+	double 												mWeightUnit;
+	long long 											mMaxIntEdgeWeight;
+	/* Compact mode: the fan-out edges of the vertex of index v are [offsets[v], offsets[v + 1]),
+	sorted by target index so that a weight is found by binary search; the fan-in ones hold no weight */
+	bool 												mIsCompact;
+	std::vector<unsigned int> 							mvFanoutOffsets;
+	std::vector<unsigned int> 							mvFanoutTargets;
+	std::vector<float> 									mvFanoutWeights;
+	std::vector<unsigned int> 							mvFaninOffsets;
+	std::vector<unsigned int> 							mvFaninSources;
+	/* Compact mode: the arrays in use, the vectors above, the ones of the mapped image or the ones of the original of a copy;
+	NULL until the import is over */
+	const GraphImage* 									mpImage;
+	const unsigned int* 								mpFanoutOffsets;
+	const unsigned int* 								mpFanoutTargets;
+	const float* 										mpFanoutWeights;
+	const unsigned int* 								mpFaninOffsets;
+	const unsigned int* 								mpFaninSources;
+	/* Compact mode: the vertex objects in one block, and the ID index as (ID, vertex) pairs sorted by ID once the import is over */
+	std::vector<BaseVertex> 							mvVertexBlock;
+	std::vector<std::pair<int, BaseVertex*>> 			mvVertexIdIndex;
+	/* The original graph of a copy, NULL otherwise: the vertices, the ID index and the edges belong to it */
+	const Graph* 										mpOriginal;
 	/* Graph modification */
 	std::set<int> 										msRemovedVertexIds;
 	std::set<std::pair<int, int>> 						msRemovedEdge;
 
 private:
+	struct CompactEdge;
+
 	void importFromFile(const std::string &file_name);
+	void reorderVertices(VertexOrder vertex_order);
+	void buildCompactArrays(std::vector<CompactEdge> &edges);
+	void pointToCompactArrays();
+	BaseVertex* findVertex(int node_id) const;
+	const Graph& getOriginal() const 	{ return mpOriginal == NULL ? *this : *mpOriginal; }
 };
 
 #endif // __GRAPH_H__
@@ -0,0 +1,213 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "GraphGenerator.h"
+
+typedef std::pair<int, int> Link;
+
+/* Write the two directed edges of every link, the file ends with "-1" as the importer allows it. */
+static void writeLinks(const std::string &file_name, int vertex_num, const std::vector<Link> &links, const std::vector<double> &weights)
+{
+	std::ofstream ofs(file_name.c_str());
+	if (!ofs)
+	{
+		std::cerr << "The file " << file_name << " can not be opened!" << std::endl;
+		exit(1);
+	}
+	ofs << vertex_num << "\n\n";
+	for (size_t i = 0; i < links.size(); ++i)
+	{
+		ofs << links[i].first << ' ' << links[i].second << ' ' << weights[i] << '\n';
+		ofs << links[i].second << ' ' << links[i].first << ' ' << weights[i] << '\n';
+	}
+	ofs << "-1\n";
+}
+
+void GraphGenerator::writeGrid(const std::string &file_name, int rows, int cols)
+{
+	std::mt19937 rng(mSeed);
+	std::uniform_real_distribution<double> block_length(0.08, 0.12);
+	std::vector<Link> links;
+	std::vector<double> weights;
+	for (int r = 0; r < rows; ++r)
+	{
+		for (int c = 0; c < cols; ++c)
+		{
+			int v = r * cols + c;
+			if (c + 1 < cols)
+			{
+				links.push_back(std::make_pair(v, v + 1));
+				weights.push_back(block_length(rng));
+			}
+			if (r + 1 < rows)
+			{
+				links.push_back(std::make_pair(v, v + cols));
+				weights.push_back(block_length(rng));
+			}
+		}
+	}
+	writeLinks(file_name, rows * cols, links, weights);
+}
+
+void GraphGenerator::writeRandomGeometric(const std::string &file_name, int vertex_num, double avg_degree)
+{
+	std::mt19937 rng(mSeed);
+	// about one intersection per 100 m x 100 m
+	double side = std::sqrt((double)vertex_num) * 0.1;
+	double radius = side * std::sqrt(avg_degree / (M_PI * vertex_num));
+	std::uniform_real_distribution<double> coordinate(0, side);
+	std::vector<double> xs(vertex_num), ys(vertex_num);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		xs[v] = coordinate(rng);
+		ys[v] = coordinate(rng);
+	}
+
+	// bucket the points in cells of one radius so that only the 3x3 surrounding cells are checked
+	int cell_num = std::max(1, (int)(side / radius));
+	std::vector<std::vector<int>> cells((size_t)cell_num * cell_num);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		int cx = std::min(cell_num - 1, (int)(xs[v] / side * cell_num));
+		int cy = std::min(cell_num - 1, (int)(ys[v] / side * cell_num));
+		cells[(size_t)cy * cell_num + cx].push_back(v);
+	}
+
+	std::vector<Link> links;
+	std::vector<double> weights;
+	std::vector<int> degree(vertex_num, 0);
+	for (int cy = 0; cy < cell_num; ++cy)
+	{
+		for (int cx = 0; cx < cell_num; ++cx)
+		{
+			const std::vector<int> &cell = cells[(size_t)cy * cell_num + cx];
+			for (int ny = std::max(0, cy - 1); ny <= std::min(cell_num - 1, cy + 1); ++ny)
+			{
+				for (int nx = std::max(0, cx - 1); nx <= std::min(cell_num - 1, cx + 1); ++nx)
+				{
+					const std::vector<int> &neighbor_cell = cells[(size_t)ny * cell_num + nx];
+					for (size_t i = 0; i < cell.size(); ++i)
+					{
+						for (size_t j = 0; j < neighbor_cell.size(); ++j)
+						{
+							int u = cell[i], v = neighbor_cell[j];
+							if (u >= v)
+							{
+								continue; // every pair once
+							}
+							double distance = std::hypot(xs[u] - xs[v], ys[u] - ys[v]);
+							if (distance <= radius)
+							{
+								links.push_back(std::make_pair(u, v));
+								weights.push_back(std::max(distance, 0.001));
+								++degree[u];
+								++degree[v];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// the importer needs every vertex in an edge: hook isolated points to another one
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		if (degree[v] == 0)
+		{
+			int u = v == 0 ? 1 : v - 1;
+			links.push_back(std::make_pair(u, v));
+			weights.push_back(std::max(std::hypot(xs[u] - xs[v], ys[u] - ys[v]), 0.001));
+			++degree[u];
+			++degree[v];
+		}
+	}
+
+	// list the links in random order, as an unsorted export would, rather than cell by cell
+	std::vector<size_t> link_order(links.size());
+	for (size_t i = 0; i < link_order.size(); ++i)
+	{
+		link_order[i] = i;
+	}
+	std::shuffle(link_order.begin(), link_order.end(), rng);
+	std::vector<Link> shuffled_links(links.size());
+	std::vector<double> shuffled_weights(links.size());
+	for (size_t i = 0; i < link_order.size(); ++i)
+	{
+		shuffled_links[i] = links[link_order[i]];
+		shuffled_weights[i] = weights[link_order[i]];
+	}
+	writeLinks(file_name, vertex_num, shuffled_links, shuffled_weights);
+}
+
+void GraphGenerator::writeScaleFree(const std::string &file_name, int vertex_num, int link_num)
+{
+	std::mt19937 rng(mSeed);
+	std::uniform_real_distribution<double> road_length(0.05, 1.0);
+	std::vector<Link> links;
+	std::vector<double> weights;
+	// every link end is recorded once, so a uniform pick in the list is proportional to the degree
+	std::vector<int> link_ends;
+
+	// start from a small clique
+	int seed_num = std::min(vertex_num, link_num + 1);
+	for (int u = 0; u < seed_num; ++u)
+	{
+		for (int v = u + 1; v < seed_num; ++v)
+		{
+			links.push_back(std::make_pair(u, v));
+			weights.push_back(road_length(rng));
+			link_ends.push_back(u);
+			link_ends.push_back(v);
+		}
+	}
+
+	std::vector<int> targets;
+	for (int v = seed_num; v < vertex_num; ++v)
+	{
+		targets.clear();
+		while ((int)targets.size() < link_num)
+		{
+			int u = link_ends[std::uniform_int_distribution<size_t>(0, link_ends.size() - 1)(rng)];
+			if (std::find(targets.begin(), targets.end(), u) == targets.end())
+			{
+				targets.push_back(u);
+			}
+		}
+		for (size_t i = 0; i < targets.size(); ++i)
+		{
+			links.push_back(std::make_pair(targets[i], v));
+			weights.push_back(road_length(rng));
+			link_ends.push_back(targets[i]);
+			link_ends.push_back(v);
+		}
+	}
+	writeLinks(file_name, vertex_num, links, weights);
+}
+
+void GraphGenerator::writeByEdgeNum(const std::string &file_name, const std::string &kind, long long edge_num)
+{
+	if (kind == "grid")
+	{
+		// a side x side lattice has about 4 x side^2 directed edges
+		int side = std::max(2, (int)std::sqrt(edge_num / 4.0));
+		writeGrid(file_name, side, side);
+	}
+	else if (kind == "geometric")
+	{
+		writeRandomGeometric(file_name, std::max(2, (int)(edge_num / 6)), 6);
+	}
+	else if (kind == "scalefree")
+	{
+		writeScaleFree(file_name, std::max(4, (int)(edge_num / 6)), 3);
+	}
+	else
+	{
+		std::cerr << "Unknown graph kind: " << kind << std::endl;
+		exit(1);
+	}
+}
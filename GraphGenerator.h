@@ -0,0 +1,25 @@
+#ifndef __GRAPHGENERATOR_H__
+#define __GRAPHGENERATOR_H__
+
+/* Synthetic road-like graphs written in the graph file format read by Graph:
+the number of vertices on the first line, then one directed edge "start end weight" per line.
+Every street is two-way, so each generated link gives two directed edges. Weights are in km. */
+class GraphGenerator
+{
+public:
+	GraphGenerator(unsigned int seed) : mSeed(seed) {}
+
+	/* rows x cols lattice, each vertex linked to its 4 neighbors, blocks of about 100 m */
+	void 	writeGrid(const std::string &file_name, int rows, int cols);
+	/* vertex_num points scattered on a square, linked to the points within a radius giving avg_degree links */
+	void 	writeRandomGeometric(const std::string &file_name, int vertex_num, double avg_degree);
+	/* Barabasi-Albert preferential attachment, each new vertex bringing link_num links */
+	void 	writeScaleFree(const std::string &file_name, int vertex_num, int link_num);
+	/* Pick the generator parameters so that the file holds about edge_num directed edges */
+	void 	writeByEdgeNum(const std::string &file_name, const std::string &kind, long long edge_num);
+
+private:
+	unsigned int 	mSeed;
+};
+
+#endif // __GRAPHGENERATOR_H__
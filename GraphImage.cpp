@@ -0,0 +1,83 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "GraphImage.h"
+
+const int GraphImage::VERSION;
+
+static const char IMAGE_MAGIC[8] = {'D', 'S', 'C', 'G', 'R', 'A', 'P', 'H'};
+
+static size_t alignedBytes(size_t byte_num)
+{
+	return (byte_num + 7) & ~(size_t)7;
+}
+
+void GraphImage::getLayout(int vertex_num, long long edge_num, std::vector<size_t> &positions, size_t &byte_num)
+{
+	size_t sizes[6] = {vertex_num * sizeof(int),
+					   (vertex_num + 1) * sizeof(unsigned int), edge_num * sizeof(unsigned int), edge_num * sizeof(float),
+					   (vertex_num + 1) * sizeof(unsigned int), edge_num * sizeof(unsigned int)};
+	positions.clear();
+	byte_num = alignedBytes(sizeof(Header));
+	for (int i = 0; i < 6; ++i)
+	{
+		positions.push_back(byte_num);
+		byte_num += alignedBytes(sizes[i]);
+	}
+}
+
+bool GraphImage::readHeader(const std::string &file_name, Header &header)
+{
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	bool is_read = read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+	close(fd);
+	return is_read && memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0 && header.version == VERSION;
+}
+
+GraphImage::GraphImage(const std::string &file_name)
+{
+	int fd = open(file_name.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if (fd < 0 || fstat(fd, &file_stat) != 0)
+	{
+		std::cerr << "The image " << file_name << " can not be opened: " << strerror(errno) << std::endl;
+		exit(1);
+	}
+	mByteNum = file_stat.st_size;
+	void *data = mByteNum >= sizeof(Header) ? mmap(NULL, mByteNum, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		std::cerr << "The image " << file_name << " can not be mapped." << std::endl;
+		exit(1);
+	}
+	mpData = (const char *)data;
+	mpHeader = (const Header *)data;
+
+	size_t byte_num = 0;
+	if (memcmp(mpHeader->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0 && mpHeader->version == VERSION && mpHeader->vertex_num >= 0 && mpHeader->edge_num >= 0)
+	{
+		getLayout(mpHeader->vertex_num, mpHeader->edge_num, mvPositions, byte_num);
+	}
+	if (byte_num == 0 || byte_num != mByteNum)
+	{
+		std::cerr << "The file " << file_name << " is not a graph image of version " << VERSION << "." << std::endl;
+		exit(1);
+	}
+}
+
+GraphImage::~GraphImage(void)
+{
+	munmap((void *)mpData, mByteNum);
+}
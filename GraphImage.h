@@ -0,0 +1,56 @@
+#ifndef __GRAPHIMAGE_H__
+#define __GRAPHIMAGE_H__
+
+/* Binary image of a graph in the compact mode, written once by Graph::saveImage and mapped read-only (POSIX only).
+Any number of processes mapping the same file share its pages: a Graph built on the image keeps its packed edge arrays
+in place, only the vertex objects and their ID index are its own.
+The layout is a header followed by the arrays, each one starting on 8 bytes:
+	vertex IDs by internal index				int[vertex_num]
+	fan-out offsets, targets, weights			unsigned int[vertex_num + 1], unsigned int[edge_num], float[edge_num]
+	fan-in offsets, sources						unsigned int[vertex_num + 1], unsigned int[edge_num]
+The program ends with a message if the file can not be mapped or is not an image of this version. */
+class GraphImage
+{
+public:
+	struct Header
+	{
+		char 		magic[8];
+		int 		version;
+		int 		vertex_num;
+		long long 	edge_num;
+		double 		weight_unit;
+		long long 	max_int_edge_weight;
+		/* Graph::VertexOrder of the import */
+		int 		vertex_order;
+	};
+	static const int 			VERSION = 2;
+
+	GraphImage(const std::string &file_name);
+	~GraphImage(void);
+
+	/* Read the header of an image of this version without mapping it, false if there is none */
+	static bool 				readHeader(const std::string &file_name, Header &header);
+	/* Byte positions of the arrays after the header, for the writer and the reader alike */
+	static void 				getLayout(int vertex_num, long long edge_num, std::vector<size_t> &positions, size_t &byte_num);
+
+	int 						getVertexNum() const 				{ return mpHeader->vertex_num; }
+	long long 					getEdgeNum() const 					{ return mpHeader->edge_num; }
+	double 						getWeightUnit() const 				{ return mpHeader->weight_unit; }
+	long long 					getMaxIntEdgeWeight() const 		{ return mpHeader->max_int_edge_weight; }
+	int 						getVertexOrder() const 				{ return mpHeader->vertex_order; }
+	size_t 						getByteNum() const 					{ return mByteNum; }
+	const int* 					getVertexIds() const 				{ return (const int *)(mpData + mvPositions[0]); }
+	const unsigned int* 		getFanoutOffsets() const 			{ return (const unsigned int *)(mpData + mvPositions[1]); }
+	const unsigned int* 		getFanoutTargets() const 			{ return (const unsigned int *)(mpData + mvPositions[2]); }
+	const float* 				getFanoutWeights() const 			{ return (const float *)(mpData + mvPositions[3]); }
+	const unsigned int* 		getFaninOffsets() const 			{ return (const unsigned int *)(mpData + mvPositions[4]); }
+	const unsigned int* 		getFaninSources() const 			{ return (const unsigned int *)(mpData + mvPositions[5]); }
+
+private:
+	const char* 				mpData;
+	const Header* 				mpHeader;
+	size_t 						mByteNum;
+	std::vector<size_t> 		mvPositions;
+};
+
+#endif // __GRAPHIMAGE_H__
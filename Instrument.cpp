@@ -0,0 +1,162 @@
+#include <mutex>
+#include <thread>
+#include <iomanip>
+#include <sstream>
+#include "Instrument.h"
+
+static const char *COUNTER_NAMES[Instrument::COUNTER_NUM] = {
+	"settled_vertices", "relaxations", "spur_candidates", "yen_iterations", "backward_corrections"};
+static const char *PHASE_NAMES[Instrument::PHASE_NUM] = {
+	"Graph::importFromFile", "Dijkstra::determineShortestPaths", "Yen::next", "Yen::reverseTree",
+	"Dijkstra::updateCostForward", "Dijkstra::correctCostBackward"};
+/* Beyond that, trace events are dropped and only the summaries keep being updated */
+static const size_t MAX_TRACE_EVENT_NUM = 1000000;
+
+struct QueryRecord
+{
+	std::string 	name;
+	int 			thread_index;
+	double 			begin_us;
+	double 			end_us;
+	long long 		counters[Instrument::COUNTER_NUM];
+	long long 		phase_calls[Instrument::PHASE_NUM];
+	double 			phase_us[Instrument::PHASE_NUM];
+};
+
+struct TraceEvent
+{
+	int 		phase;
+	int 		thread_index;
+	double 		begin_us;
+	double 		duration_us;
+};
+
+static const std::chrono::steady_clock::time_point 	gEpoch = std::chrono::steady_clock::now();
+static std::mutex 									gMutex;
+static std::vector<QueryRecord> 					gvQueries;
+static std::vector<TraceEvent> 						gvTraceEvents;
+static bool 										gIsTraceEnabled = false;
+static int 											gThreadNum = 0;
+
+/* The query in progress on the current thread */
+static thread_local QueryRecord 					tCurrentQuery;
+static thread_local bool 							tIsInQuery = false;
+static thread_local int 							tThreadIndex = -1;
+
+static double sinceEpochUs(const std::chrono::steady_clock::time_point &time_point)
+{
+	return std::chrono::duration<double, std::micro>(time_point - gEpoch).count();
+}
+
+static int threadIndex()
+{
+	if (tThreadIndex < 0)
+	{
+		std::lock_guard<std::mutex> lock(gMutex);
+		tThreadIndex = gThreadNum++;
+	}
+	return tThreadIndex;
+}
+
+void Instrument::beginQuery(const std::string &query_name)
+{
+	tCurrentQuery = QueryRecord();
+	tCurrentQuery.name = query_name;
+	tCurrentQuery.thread_index = threadIndex();
+	tCurrentQuery.begin_us = sinceEpochUs(std::chrono::steady_clock::now());
+	tIsInQuery = true;
+}
+
+void Instrument::endQuery()
+{
+	if (!tIsInQuery)
+	{
+		return;
+	}
+	tIsInQuery = false;
+	tCurrentQuery.end_us = sinceEpochUs(std::chrono::steady_clock::now());
+	std::lock_guard<std::mutex> lock(gMutex);
+	gvQueries.push_back(tCurrentQuery);
+}
+
+void Instrument::count(Counter counter, long long value)
+{
+	tCurrentQuery.counters[counter] += value;
+}
+
+void Instrument::addPhase(Phase phase, const std::chrono::steady_clock::time_point &start, const std::chrono::steady_clock::time_point &end)
+{
+	double begin_us = sinceEpochUs(start);
+	double duration_us = std::chrono::duration<double, std::micro>(end - start).count();
+	++tCurrentQuery.phase_calls[phase];
+	tCurrentQuery.phase_us[phase] += duration_us;
+	if (gIsTraceEnabled)
+	{
+		TraceEvent event = {phase, threadIndex(), begin_us, duration_us};
+		std::lock_guard<std::mutex> lock(gMutex);
+		if (gvTraceEvents.size() < MAX_TRACE_EVENT_NUM)
+		{
+			gvTraceEvents.push_back(event);
+		}
+	}
+}
+
+void Instrument::enableTrace(bool is_enabled)
+{
+	gIsTraceEnabled = is_enabled;
+}
+
+void Instrument::writeSummary(std::ostream &out_stream)
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+	std::ios::fmtflags flags = out_stream.flags();
+	std::streamsize precision = out_stream.precision();
+	out_stream << std::fixed << std::setprecision(3) << "[";
+	for (size_t i = 0; i < gvQueries.size(); ++i)
+	{
+		const QueryRecord &query = gvQueries[i];
+		out_stream << (i == 0 ? "\n" : ",\n") << "  {\"query\":\"" << query.name << "\",\"thread\":" << query.thread_index
+				   << ",\"ms\":" << (query.end_us - query.begin_us) / 1000 << ",\"counters\":{";
+		for (int c = 0; c < COUNTER_NUM; ++c)
+		{
+			out_stream << (c == 0 ? "" : ",") << "\"" << COUNTER_NAMES[c] << "\":" << query.counters[c];
+		}
+		out_stream << "},\"phases\":{";
+		for (int p = 0; p < PHASE_NUM; ++p)
+		{
+			out_stream << (p == 0 ? "" : ",") << "\"" << PHASE_NAMES[p] << "\":{\"calls\":" << query.phase_calls[p]
+					   << ",\"ms\":" << query.phase_us[p] / 1000 << "}";
+		}
+		out_stream << "}}";
+	}
+	out_stream << "\n]" << std::endl;
+	out_stream.flags(flags);
+	out_stream.precision(precision);
+}
+
+void Instrument::writeTrace(std::ostream &out_stream)
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+	std::ios::fmtflags flags = out_stream.flags();
+	std::streamsize precision = out_stream.precision();
+	out_stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+	bool is_first = true;
+	// one complete event per query spanning its phases
+	for (size_t i = 0; i < gvQueries.size(); ++i)
+	{
+		const QueryRecord &query = gvQueries[i];
+		out_stream << (is_first ? "\n" : ",\n") << "{\"name\":\"" << query.name << "\",\"cat\":\"query\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				   << query.thread_index << ",\"ts\":" << query.begin_us << ",\"dur\":" << query.end_us - query.begin_us << "}";
+		is_first = false;
+	}
+	for (size_t i = 0; i < gvTraceEvents.size(); ++i)
+	{
+		const TraceEvent &event = gvTraceEvents[i];
+		out_stream << (is_first ? "\n" : ",\n") << "{\"name\":\"" << PHASE_NAMES[event.phase] << "\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				   << event.thread_index << ",\"ts\":" << event.begin_us << ",\"dur\":" << event.duration_us << "}";
+		is_first = false;
+	}
+	out_stream << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+	out_stream.flags(flags);
+	out_stream.precision(precision);
+}
@@ -0,0 +1,73 @@
+#ifndef __INSTRUMENT_H__
+#define __INSTRUMENT_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/* Per-query counters and phase timers of the search algorithms.
+Everything is compiled in only when DSC_INSTRUMENT is defined, otherwise the macros below expand to nothing.
+Counters and timers are kept per thread; a query is the span between beginQuery() and endQuery() on one thread.
+Finished queries are exported as a JSON summary, phase timings also as Chrome trace events (chrome://tracing). */
+class Instrument
+{
+public:
+	enum Counter
+	{
+		SETTLED_VERTICES, 		// vertices settled by Dijkstra::determineShortestPaths
+		RELAXATIONS, 			// edges relaxed by Dijkstra::improve2Vertex
+		SPUR_CANDIDATES, 		// candidate paths composed by Yen::next
+		YEN_ITERATIONS, 		// calls to Yen::next
+		BACKWARD_CORRECTIONS, 	// costs lowered by Dijkstra::correctCostBackward
+		COUNTER_NUM
+	};
+	enum Phase
+	{
+		GRAPH_IMPORT, 			// Graph::importFromFile
+		SHORTEST_PATHS, 		// Dijkstra::determineShortestPaths
+		YEN_NEXT, 				// Yen::next
+		REVERSE_TREE, 			// the reverse shortest path tree built in Yen::next
+		UPDATE_COST_FORWARD, 	// Dijkstra::updateCostForward
+		CORRECT_COST_BACKWARD, 	// Dijkstra::correctCostBackward
+		PHASE_NUM
+	};
+
+	/* Times a phase from construction to destruction. */
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(Phase phase) : mPhase(phase), mStart(std::chrono::steady_clock::now()) {}
+		~ScopedTimer(void) 		{ Instrument::addPhase(mPhase, mStart, std::chrono::steady_clock::now()); }
+
+	private:
+		Phase 									mPhase;
+		std::chrono::steady_clock::time_point 	mStart;
+	};
+
+	static void 	beginQuery(const std::string &query_name);
+	static void 	endQuery();
+	static void 	count(Counter counter, long long value = 1);
+	static void 	addPhase(Phase phase, const std::chrono::steady_clock::time_point &start, const std::chrono::steady_clock::time_point &end);
+	static void 	enableTrace(bool is_enabled);
+	static void 	writeSummary(std::ostream &out_stream);
+	static void 	writeTrace(std::ostream &out_stream);
+};
+
+#ifdef DSC_INSTRUMENT
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_COUNT(counter) Instrument::count(Instrument::counter)
+#define INSTRUMENT_ADD(counter, value) Instrument::count(Instrument::counter, value)
+#define INSTRUMENT_SCOPE(phase) Instrument::ScopedTimer INSTRUMENT_CONCAT(instrument_timer_, __LINE__)(Instrument::phase)
+#define INSTRUMENT_BEGIN_QUERY(query_name) Instrument::beginQuery(query_name)
+#define INSTRUMENT_END_QUERY() Instrument::endQuery()
+#else
+#define INSTRUMENT_COUNT(counter) ((void)0)
+#define INSTRUMENT_ADD(counter, value) ((void)0)
+#define INSTRUMENT_SCOPE(phase) ((void)0)
+#define INSTRUMENT_BEGIN_QUERY(query_name) ((void)0)
+#define INSTRUMENT_END_QUERY() ((void)0)
+#endif
+
+#endif // __INSTRUMENT_H__
@@ -0,0 +1,195 @@
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "LineSocket.h"
+
+static const int LISTEN_BACKLOG = 128;
+static const size_t READ_CHUNK_SIZE = 4096;
+
+LineSocket::~LineSocket(void)
+{
+	if (mFd >= 0)
+	{
+		close(mFd);
+	}
+}
+
+static void fail(const std::string &action)
+{
+	std::cerr << "Socket error on " << action << ": " << strerror(errno) << std::endl;
+	exit(1);
+}
+
+static sockaddr_un unixAddress(const std::string &path)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "The socket path is too long: " << path << std::endl;
+		exit(1);
+	}
+	strcpy(address.sun_path, path.c_str());
+	return address;
+}
+
+static sockaddr_in loopbackAddress(int port)
+{
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return address;
+}
+
+int LineSocket::listenUnix(const std::string &path)
+{
+	sockaddr_un address = unixAddress(path);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		fail("socket");
+	}
+	// a socket file left by a previous run would make bind fail
+	unlink(path.c_str());
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0 || listen(fd, LISTEN_BACKLOG) < 0)
+	{
+		fail("listen " + path);
+	}
+	return fd;
+}
+
+int LineSocket::listenTcp(int port)
+{
+	sockaddr_in address = loopbackAddress(port);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		fail("socket");
+	}
+	int is_reused = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &is_reused, sizeof(is_reused));
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0 || listen(fd, LISTEN_BACKLOG) < 0)
+	{
+		fail("listen on port " + std::to_string(port));
+	}
+	return fd;
+}
+
+int LineSocket::connectUnix(const std::string &path)
+{
+	sockaddr_un address = unixAddress(path);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+	{
+		fail("connect " + path);
+	}
+	return fd;
+}
+
+/* Small pipelined lines should not wait for Nagle's algorithm; no effect on a Unix-domain socket */
+static void setNoDelay(int fd)
+{
+	int is_no_delay = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &is_no_delay, sizeof(is_no_delay));
+}
+
+int LineSocket::connectTcp(int port)
+{
+	sockaddr_in address = loopbackAddress(port);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+	{
+		fail("connect to port " + std::to_string(port));
+	}
+	setNoDelay(fd);
+	return fd;
+}
+
+int LineSocket::acceptConnection(int listen_fd)
+{
+	int fd = -1;
+	do
+	{
+		fd = accept(listen_fd, NULL, NULL);
+	} while (fd < 0 && errno == EINTR);
+	if (fd >= 0)
+	{
+		setNoDelay(fd);
+	}
+	return fd;
+}
+
+bool LineSocket::readLine(std::string &line)
+{
+	while (true)
+	{
+		size_t end_pos = mBuffer.find('\n', mBufferPos);
+		if (end_pos != std::string::npos)
+		{
+			line.assign(mBuffer, mBufferPos, end_pos - mBufferPos);
+			if (!line.empty() && line[line.size() - 1] == '\r')
+			{
+				line.erase(line.size() - 1);
+			}
+			mBufferPos = end_pos + 1;
+			return true;
+		}
+
+		// keep the unread part only, then wait for more
+		mBuffer.erase(0, mBufferPos);
+		mBufferPos = 0;
+		char chunk[READ_CHUNK_SIZE];
+		ssize_t read_num = read(mFd, chunk, sizeof(chunk));
+		if (read_num < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (read_num <= 0)
+		{
+			// a last line without its end still counts
+			if (mBuffer.empty())
+			{
+				return false;
+			}
+			line.swap(mBuffer);
+			mBuffer.clear();
+			return true;
+		}
+		mBuffer.append(chunk, read_num);
+	}
+}
+
+bool LineSocket::writeAll(const std::string &text)
+{
+	size_t written = 0;
+	while (written < text.size())
+	{
+		ssize_t write_num = send(mFd, text.data() + written, text.size() - written, MSG_NOSIGNAL);
+		if (write_num < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (write_num <= 0)
+		{
+			return false;
+		}
+		written += write_num;
+	}
+	return true;
+}
+
+void LineSocket::shutdownWrite()
+{
+	shutdown(mFd, SHUT_WR);
+}
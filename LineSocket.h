@@ -0,0 +1,38 @@
+#ifndef __LINESOCKET_H__
+#define __LINESOCKET_H__
+
+#include <string>
+
+/* Stream socket exchanging text lines, on a Unix-domain path or on the loopback TCP interface (POSIX only).
+One thread may read lines while another one writes. The socket is closed on destruction. */
+class LineSocket
+{
+public:
+	LineSocket(int fd) : mFd(fd), mBufferPos(0) {}
+	~LineSocket(void);
+
+	/* Listening and connected sockets, the program ends with a message on failure */
+	static int 		listenUnix(const std::string &path);
+	static int 		listenTcp(int port);
+	static int 		connectUnix(const std::string &path);
+	static int 		connectTcp(int port);
+	/* Wait for the next connection, -1 on failure */
+	static int 		acceptConnection(int listen_fd);
+
+	/* Read one line without its end, false at the end of the stream */
+	bool 			readLine(std::string &line);
+	/* A whole line is already read from the socket: readLine returns it without waiting */
+	bool 			hasBufferedLine() const 				{ return mBuffer.find('\n', mBufferPos) != std::string::npos; }
+	/* Write the whole text, false if the peer is gone */
+	bool 			writeAll(const std::string &text);
+	/* Tell the peer that nothing more will be written */
+	void 			shutdownWrite();
+	int 			getFd() const 							{ return mFd; }
+
+private:
+	int 			mFd;
+	std::string 	mBuffer;
+	size_t 			mBufferPos;
+};
+
+#endif // __LINESOCKET_H__
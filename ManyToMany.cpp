@@ -0,0 +1,162 @@
+#include <set>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <functional>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "FlatGraph.h"
+#include "ManyToMany.h"
+
+static const double UNREACHED = std::numeric_limits<double>::infinity();
+
+/* Relax one edge of weight w for all lanes: dst = min(dst, src + w).
+Return the bit mask of the lanes that have been improved. */
+static inline int relaxLanes(double *dst, const double *src, double w)
+{
+#if defined(__AVX__)
+	__m256d candidate = _mm256_add_pd(_mm256_loadu_pd(src), _mm256_set1_pd(w));
+	__m256d current = _mm256_loadu_pd(dst);
+	int mask = _mm256_movemask_pd(_mm256_cmp_pd(candidate, current, _CMP_LT_OQ));
+	if (mask)
+	{
+		_mm256_storeu_pd(dst, _mm256_min_pd(candidate, current));
+	}
+	return mask;
+#elif defined(__SSE2__)
+	__m128d weight = _mm_set1_pd(w);
+	__m128d candidate_lo = _mm_add_pd(_mm_loadu_pd(src), weight);
+	__m128d candidate_hi = _mm_add_pd(_mm_loadu_pd(src + 2), weight);
+	__m128d current_lo = _mm_loadu_pd(dst);
+	__m128d current_hi = _mm_loadu_pd(dst + 2);
+	int mask = _mm_movemask_pd(_mm_cmplt_pd(candidate_lo, current_lo)) | (_mm_movemask_pd(_mm_cmplt_pd(candidate_hi, current_hi)) << 2);
+	if (mask)
+	{
+		_mm_storeu_pd(dst, _mm_min_pd(candidate_lo, current_lo));
+		_mm_storeu_pd(dst + 2, _mm_min_pd(candidate_hi, current_hi));
+	}
+	return mask;
+#else
+	int mask = 0;
+	for (int lane = 0; lane < ManyToMany::LANE_NUM; ++lane)
+	{
+		double candidate = src[lane] + w;
+		if (candidate < dst[lane])
+		{
+			dst[lane] = candidate;
+			mask |= 1 << lane;
+		}
+	}
+	return mask;
+#endif
+}
+
+void ManyToMany::getDistanceMatrix(const std::vector<BaseVertex *> &sources, const std::vector<BaseVertex *> &targets,
+								   std::vector<double> &matrix, int thread_num)
+{
+	int source_num = sources.size();
+	int target_num = targets.size();
+	int batch_num = (source_num + LANE_NUM - 1) / LANE_NUM;
+	matrix.assign((size_t)source_num * target_num, Graph::DISCONNECT);
+	if (thread_num < 1)
+	{
+		thread_num = 1;
+	}
+	if (thread_num > batch_num)
+	{
+		thread_num = batch_num;
+	}
+
+	// every worker takes the next batch of sources until there is none left
+	std::atomic<int> next_batch(0);
+	std::function<void()> worker = [&]()
+	{
+		std::vector<double> lane_distances;
+		std::vector<unsigned char> dirty_lanes;
+		for (int batch = next_batch++; batch < batch_num; batch = next_batch++)
+		{
+			int first_source = batch * LANE_NUM;
+			searchBatch(sources, first_source, lane_distances, dirty_lanes);
+			for (int lane = 0; lane < LANE_NUM && first_source + lane < source_num; ++lane)
+			{
+				double *row = &matrix[(size_t)(first_source + lane) * target_num];
+				for (int t = 0; t < target_num; ++t)
+				{
+					double distance = lane_distances[(size_t)targets[t]->getIndex() * LANE_NUM + lane];
+					row[t] = distance < UNREACHED ? distance : Graph::DISCONNECT;
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < thread_num; ++i)
+	{
+		threads.push_back(std::thread(worker));
+	}
+	worker();
+	for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+}
+
+/* Label-correcting search of up to LANE_NUM sources at once.
+A vertex is queued with the smallest of its improved lanes and, when popped, relaxes all of its lanes
+along every fan-out edge; it is queued again whenever one of its lanes improves later on. */
+void ManyToMany::searchBatch(const std::vector<BaseVertex *> &sources, int first_source, std::vector<double> &lane_distances,
+							 std::vector<unsigned char> &dirty_lanes)
+{
+	typedef std::pair<double, int> QueueItem;
+	int vertex_num = mFlatGraph.getVertexNum();
+	lane_distances.assign((size_t)vertex_num * LANE_NUM, UNREACHED);
+	dirty_lanes.assign(vertex_num, 0);
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> candidates;
+
+	// initiate one lane per source
+	for (int lane = 0; lane < LANE_NUM && first_source + lane < (int)sources.size(); ++lane)
+	{
+		int v = sources[first_source + lane]->getIndex();
+		lane_distances[(size_t)v * LANE_NUM + lane] = 0;
+		dirty_lanes[v] |= 1 << lane;
+		candidates.push(std::make_pair(0.0, v));
+	}
+
+	while (!candidates.empty())
+	{
+		int v = candidates.top().second;
+		candidates.pop();
+		if (dirty_lanes[v] == 0)
+		{
+			continue; // already scanned with its latest distances
+		}
+		dirty_lanes[v] = 0;
+		const double *v_distances = &lane_distances[(size_t)v * LANE_NUM];
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			int w = mFlatGraph.outTarget(e);
+			double *w_distances = &lane_distances[(size_t)w * LANE_NUM];
+			int improved = relaxLanes(w_distances, v_distances, mFlatGraph.outWeight(e));
+			if (improved)
+			{
+				double key = UNREACHED;
+				for (int lane = 0; lane < LANE_NUM; ++lane)
+				{
+					if ((improved >> lane & 1) && w_distances[lane] < key)
+					{
+						key = w_distances[lane];
+					}
+				}
+				dirty_lanes[w] |= improved;
+				candidates.push(std::make_pair(key, w));
+			}
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef __MANYTOMANY_H__
+#define __MANYTOMANY_H__
+
+/* Many-to-many shortest distances between a set of sources and a set of targets.
+Sources are searched in batches of LANE_NUM that run in lockstep: every vertex keeps one distance
+lane per source of the batch and an edge is relaxed for all lanes at once (AVX/SSE2 when available).
+Batches are independent and spread over worker threads. */
+class ManyToMany
+{
+public:
+	static const int 	LANE_NUM = 4;
+
+	ManyToMany(Graph *pGraph) : mFlatGraph(*pGraph) {}
+	~ManyToMany(void) {}
+
+	/* Fill matrix (row-major, sources x targets) with the shortest distances, Graph::DISCONNECT if unreachable. */
+	void 		getDistanceMatrix(const std::vector<BaseVertex*> &sources, const std::vector<BaseVertex*> &targets,
+								  std::vector<double> &matrix, int thread_num = 1);
+
+protected:
+	void 		searchBatch(const std::vector<BaseVertex*> &sources, int first_source, std::vector<double> &lane_distances,
+							std::vector<unsigned char> &dirty_lanes);
+
+private:
+	FlatGraph 	mFlatGraph;
+};
+
+#endif // __MANYTOMANY_H__
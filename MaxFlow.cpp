@@ -0,0 +1,78 @@
+#include <set>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "MaxFlow.h"
+
+bool PushRelabel_canPush(std::vector<std::vector<int>> &capacity, int src, int sink, std::vector<int> &parent)
+{
+	int N = capacity.size();
+	std::vector<int> vis(N, 0);
+	vis[src] = 1;
+	parent[src] = -1;
+	std::queue<int> q;
+	q.push(src);
+	while (!q.empty())
+	{
+		int cnode = q.front();
+		q.pop();
+		for (int i = 0; i < N; i++)
+		{
+			if (vis[i] == 0 && capacity[cnode][i] > 0)
+			{
+				vis[i] = 1;
+				parent[i] = cnode;
+				q.push(i);
+			}
+		}
+	}
+	if (vis[sink])
+		return true;
+	return false;
+}
+
+int PushRelabel_FIFO(std::vector<std::vector<int>> &capacity, int src, int sink)
+{
+	int N = capacity.size();
+	std::vector<int> parent(N);
+	int max_flow = 0;
+	while (PushRelabel_canPush(capacity, src, sink, parent))
+	{
+		int curr_flow = INT_MAX;
+		int temp = sink;
+		while (temp != src)
+		{
+			curr_flow = std::min(curr_flow, capacity[parent[temp]][temp]);
+			temp = parent[temp];
+		}
+		temp = sink;
+		while (temp != src)
+		{
+			capacity[parent[temp]][temp] -= curr_flow;
+			temp = parent[temp];
+		}
+		max_flow += curr_flow;
+	}
+	return max_flow;
+}
+
+void PushRelabel_capacities(Graph &graph, std::vector<std::vector<int>> &capacity)
+{
+	const std::vector<BaseVertex *> &vertices = graph.getVertexList();
+	int n = vertices.size();
+	capacity.assign(n, std::vector<int>(n, 0));
+	for (int u = 0; u < n; ++u)
+	{
+		std::set<BaseVertex *> adj_vertex_set;
+		graph.getAdjacentVertices(vertices[u], adj_vertex_set);
+		for (std::set<BaseVertex *>::const_iterator pos = adj_vertex_set.begin(); pos != adj_vertex_set.end(); ++pos)
+		{
+			capacity[u][(*pos)->getIndex()] = std::max(1, (int)(graph.getEdgeWeight(vertices[u], *pos) * 100 + 0.5));
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#ifndef __MAXFLOW_H__
+#define __MAXFLOW_H__
+
+/* Max flow between src and sink on a capacity matrix, by augmenting along BFS paths of the residual graph.
+The capacity matrix is consumed as the residual one. */
+bool 	PushRelabel_canPush(std::vector<std::vector<int>> &capacity, int src, int sink, std::vector<int> &parent);
+int 	PushRelabel_FIFO(std::vector<std::vector<int>> &capacity, int src, int sink);
+/* Dense capacity matrix of a graph by internal index: the edge length in units of 10 m, 1 at least */
+void 	PushRelabel_capacities(Graph &graph, std::vector<std::vector<int>> &capacity);
+
+#endif // __MAXFLOW_H__
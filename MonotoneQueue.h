@@ -0,0 +1,103 @@
+#ifndef __MONOTONEQUEUE_H__
+#define __MONOTONEQUEUE_H__
+
+#include <vector>
+#include <utility>
+
+/* Priority queues on unsigned integer keys for Dijkstra's algorithm with integer weights.
+Both are monotone: a pushed key must not be smaller than the last popped one. */
+
+/* Radix heap: bucket i holds the keys whose highest bit differing from the last popped key is bit i-1.
+Each item moves down at most 64 buckets in its life, whatever the range of the weights. */
+template <class T>
+class RadixHeap
+{
+public:
+	typedef std::pair<unsigned long long, T> 	Item;
+
+	RadixHeap(void) : mLastKey(0), mSize(0) {}
+
+	bool 	empty() const 										{ return mSize == 0; }
+	size_t 	size() const 										{ return mSize; }
+	void 	push(unsigned long long key, const T &value)
+	{
+		mvBuckets[bucketIndex(key)].push_back(Item(key, value));
+		++mSize;
+	}
+	Item 	pop()
+	{
+		if (mvBuckets[0].empty())
+		{
+			// the smallest key of the first non-empty bucket becomes the reference, its items spread over lower buckets
+			int i = 1;
+			while (mvBuckets[i].empty())
+			{
+				++i;
+			}
+			unsigned long long min_key = mvBuckets[i][0].first;
+			for (size_t j = 1; j < mvBuckets[i].size(); ++j)
+			{
+				if (mvBuckets[i][j].first < min_key)
+				{
+					min_key = mvBuckets[i][j].first;
+				}
+			}
+			mLastKey = min_key;
+			std::vector<Item> items;
+			items.swap(mvBuckets[i]);
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				mvBuckets[bucketIndex(items[j].first)].push_back(items[j]);
+			}
+		}
+		Item item = mvBuckets[0].back();
+		mvBuckets[0].pop_back();
+		--mSize;
+		return item;
+	}
+
+private:
+	unsigned long long 	mLastKey;
+	size_t 				mSize;
+	std::vector<Item> 	mvBuckets[65];
+
+	int 	bucketIndex(unsigned long long key) const 			{ return key == mLastKey ? 0 : 64 - __builtin_clzll(key ^ mLastKey); }
+};
+
+/* Dial's buckets: with edge weights in [0, max_weight], the pending keys always fit in a circular array
+of max_weight + 1 buckets, one key per bucket. Suited to small weight ranges only. */
+template <class T>
+class BucketQueue
+{
+public:
+	typedef std::pair<unsigned long long, T> 	Item;
+
+	BucketQueue(unsigned long long max_weight) : mvBuckets(max_weight + 1), mCurrentKey(0), mSize(0) {}
+
+	bool 	empty() const 										{ return mSize == 0; }
+	size_t 	size() const 										{ return mSize; }
+	void 	push(unsigned long long key, const T &value)
+	{
+		mvBuckets[key % mvBuckets.size()].push_back(Item(key, value));
+		++mSize;
+	}
+	Item 	pop()
+	{
+		while (mvBuckets[mCurrentKey % mvBuckets.size()].empty())
+		{
+			++mCurrentKey;
+		}
+		std::vector<Item> &bucket = mvBuckets[mCurrentKey % mvBuckets.size()];
+		Item item = bucket.back();
+		bucket.pop_back();
+		--mSize;
+		return item;
+	}
+
+private:
+	std::vector<std::vector<Item>> 	mvBuckets;
+	unsigned long long 				mCurrentKey;
+	size_t 							mSize;
+};
+
+#endif // __MONOTONEQUEUE_H__
@@ -0,0 +1,471 @@
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "FlatGraph.h"
+#include "MonotoneQueue.h"
+#include "SearchKernel.h"
+#include "PartitionOverlay.h"
+
+PartitionOverlay::PartitionOverlay(Graph &graph, const std::vector<int> &cell_sizes)
+	: mFlatGraph(graph), mSettledNum(0), mUnpackSettledNum(0)
+{
+	mvWeights.resize(mFlatGraph.getEdgeNum());
+	for (int e = 0; e < mFlatGraph.getEdgeNum(); ++e)
+	{
+		mvWeights[e] = mFlatGraph.outWeight(e);
+	}
+	partition(cell_sizes);
+}
+
+/* Every cell of a level is cut in two until it is small enough, the cells of the level above being the ones to cut,
+so that the cells of a level are nested in the ones of the level above. */
+void PartitionOverlay::partition(const std::vector<int> &cell_sizes)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	std::vector<int> marks(vertex_num, 0);
+	int mark = 0;
+	mvLevels.assign(cell_sizes.size(), Level());
+
+	// the whole graph is the one cell above the coarsest level
+	std::vector<std::vector<int>> upper_cells(1);
+	for (int v = 0; v < vertex_num; ++v)
+	{
+		upper_cells[0].push_back(v);
+	}
+	for (int level = (int)cell_sizes.size() - 1; level >= 0; --level)
+	{
+		std::vector<std::vector<int>> cells;
+		for (size_t i = 0; i < upper_cells.size(); ++i)
+		{
+			std::vector<std::vector<int>> pending(1, upper_cells[i]);
+			while (!pending.empty())
+			{
+				std::vector<int> vertices;
+				vertices.swap(pending.back());
+				pending.pop_back();
+				if ((int)vertices.size() <= std::max(1, cell_sizes[level]))
+				{
+					cells.push_back(std::vector<int>());
+					cells.back().swap(vertices);
+					continue;
+				}
+				std::vector<int> first_half, second_half;
+				bisect(vertices, first_half, second_half, marks, mark);
+				pending.push_back(std::vector<int>());
+				pending.back().swap(second_half);
+				pending.push_back(std::vector<int>());
+				pending.back().swap(first_half);
+			}
+		}
+
+		Level &cur_level = mvLevels[level];
+		cur_level.cell_of.assign(vertex_num, -1);
+		for (size_t c = 0; c < cells.size(); ++c)
+		{
+			for (size_t i = 0; i < cells[c].size(); ++i)
+			{
+				cur_level.cell_of[cells[c][i]] = c;
+			}
+		}
+
+		// a boundary vertex has an edge, in either direction, to another cell
+		cur_level.cells.assign(cells.size(), Cell());
+		cur_level.boundary_pos.assign(vertex_num, -1);
+		for (int v = 0; v < vertex_num; ++v)
+		{
+			int cell = cur_level.cell_of[v];
+			bool is_boundary = false;
+			for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v) && !is_boundary; ++e)
+			{
+				is_boundary = cur_level.cell_of[mFlatGraph.outTarget(e)] != cell;
+			}
+			for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v) && !is_boundary; ++e)
+			{
+				is_boundary = cur_level.cell_of[mFlatGraph.inSource(e)] != cell;
+			}
+			if (is_boundary)
+			{
+				cur_level.boundary_pos[v] = cur_level.cells[cell].boundary.size();
+				cur_level.cells[cell].boundary.push_back(v);
+			}
+		}
+		upper_cells.swap(cells);
+	}
+}
+
+/* Split a cell in two halves of the breadth-first order, edges taken in both directions, from a vertex far in the cell:
+a pseudo-peripheral vertex, the last one reached from an arbitrary one. The other components of the cell come after. */
+void PartitionOverlay::bisect(const std::vector<int> &vertices, std::vector<int> &first_half, std::vector<int> &second_half,
+							  std::vector<int> &marks, int &mark) const
+{
+	int member = ++mark;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		marks[vertices[i]] = member;
+	}
+	std::vector<int> order;
+	int start = vertices[0];
+	for (int round = 0; round < 2; ++round)
+	{
+		int visited = ++mark;
+		int far_vertex = -1;
+		size_t next_unvisited = 0;
+		order.assign(1, start);
+		marks[start] = visited;
+		for (size_t head = 0; order.size() < vertices.size(); ++head)
+		{
+			if (head == order.size())
+			{
+				far_vertex = far_vertex < 0 ? order.back() : far_vertex;
+				while (marks[vertices[next_unvisited]] == visited)
+				{
+					++next_unvisited;
+				}
+				marks[vertices[next_unvisited]] = visited;
+				order.push_back(vertices[next_unvisited]);
+			}
+			int v = order[head];
+			for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+			{
+				int u = mFlatGraph.outTarget(e);
+				if (marks[u] == member)
+				{
+					marks[u] = visited;
+					order.push_back(u);
+				}
+			}
+			for (int e = mFlatGraph.inBegin(v); e < mFlatGraph.inEnd(v); ++e)
+			{
+				int u = mFlatGraph.inSource(e);
+				if (marks[u] == member)
+				{
+					marks[u] = visited;
+					order.push_back(u);
+				}
+			}
+		}
+		start = far_vertex < 0 ? order.back() : far_vertex;
+		member = visited;
+	}
+	first_half.assign(order.begin(), order.begin() + order.size() / 2);
+	second_half.assign(order.begin() + order.size() / 2, order.end());
+}
+
+void PartitionOverlay::customize(int thread_num)
+{
+	std::vector<double> edge_weights(mFlatGraph.getEdgeNum());
+	for (int e = 0; e < mFlatGraph.getEdgeNum(); ++e)
+	{
+		edge_weights[e] = mFlatGraph.outWeight(e);
+	}
+	customize(edge_weights, thread_num);
+}
+
+/* Level by level from the finest one, as a level searches the cliques of the one below */
+void PartitionOverlay::customize(const std::vector<double> &edge_weights, int thread_num)
+{
+	mvWeights = edge_weights;
+	for (int level = 0; level < (int)mvLevels.size(); ++level)
+	{
+		int cell_num = mvLevels[level].cells.size();
+		int level_thread_num = std::max(1, std::min(thread_num, cell_num));
+
+		// every worker takes the next cell until there is none left
+		std::atomic<int> next_cell(0);
+		std::function<void()> worker = [&]()
+		{
+			SearchState state;
+			for (int cell = next_cell++; cell < cell_num; cell = next_cell++)
+			{
+				customizeCell(level, cell, state);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < level_thread_num; ++i)
+		{
+			threads.push_back(std::thread(worker));
+		}
+		worker();
+		for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+		{
+			it->join();
+		}
+	}
+}
+
+/* One search inside the cell from each of its boundary vertices: on the edges of the graph at the finest level,
+on the cliques of the subcells and the edges between them at the others */
+void PartitionOverlay::customizeCell(int level, int cell, SearchState &state)
+{
+	Level &cur_level = mvLevels[level];
+	Cell &cur_cell = cur_level.cells[cell];
+	int boundary_num = cur_cell.boundary.size();
+	cur_cell.clique.assign((size_t)boundary_num * boundary_num, Graph::DISCONNECT);
+	for (int i = 0; i < boundary_num; ++i)
+	{
+		resetState(state);
+		BinaryHeap<int> candidates;
+		auto relax = [&](int v, double distance)
+		{
+			if (state.stamps[v] != state.stamp || distance < state.distances[v])
+			{
+				state.stamps[v] = state.stamp;
+				state.distances[v] = distance;
+				candidates.push(distance, v);
+			}
+		};
+		relax(cur_cell.boundary[i], 0);
+
+		int found_num = 0;
+		while (!candidates.empty() && found_num < boundary_num)
+		{
+			BinaryHeap<int>::Item item = candidates.pop();
+			int v = item.second;
+			if (item.first > state.distances[v])
+			{
+				continue;
+			}
+			if (cur_level.boundary_pos[v] >= 0)
+			{
+				cur_cell.clique[(size_t)i * boundary_num + cur_level.boundary_pos[v]] = item.first;
+				++found_num;
+			}
+			if (level == 0)
+			{
+				for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+				{
+					if (cur_level.cell_of[mFlatGraph.outTarget(e)] == cell)
+					{
+						relax(mFlatGraph.outTarget(e), item.first + mvWeights[e]);
+					}
+				}
+				continue;
+			}
+
+			// a vertex reached at a coarser level is on the boundary of its subcell
+			const Level &sub_level = mvLevels[level - 1];
+			int sub_cell = sub_level.cell_of[v];
+			const Cell &cur_sub_cell = sub_level.cells[sub_cell];
+			int sub_boundary_num = cur_sub_cell.boundary.size();
+			const double *row = &cur_sub_cell.clique[(size_t)sub_level.boundary_pos[v] * sub_boundary_num];
+			for (int j = 0; j < sub_boundary_num; ++j)
+			{
+				if (row[j] < Graph::DISCONNECT)
+				{
+					relax(cur_sub_cell.boundary[j], item.first + row[j]);
+				}
+			}
+			for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+			{
+				int u = mFlatGraph.outTarget(e);
+				if (sub_level.cell_of[u] != sub_cell && cur_level.cell_of[u] == cell)
+				{
+					relax(u, item.first + mvWeights[e]);
+				}
+			}
+		}
+	}
+}
+
+/* The coarsest level whose cell of v holds neither the source nor the target, 0 for the edges of the graph.
+The levels are numbered from 1 here, the cliques of level l being the ones of mvLevels[l - 1]. */
+int PartitionOverlay::getQueryLevel(int v, int source, int target) const
+{
+	for (int level = mvLevels.size() - 1; level >= 0; --level)
+	{
+		const Level &cur_level = mvLevels[level];
+		if (cur_level.cell_of[v] != cur_level.cell_of[source] && cur_level.cell_of[v] != cur_level.cell_of[target] && cur_level.boundary_pos[v] >= 0)
+		{
+			return level + 1;
+		}
+	}
+	return 0;
+}
+
+BasePath *PartitionOverlay::getShortestPath(BaseVertex *source, BaseVertex *target)
+{
+	int s = source->getIndex();
+	int t = target->getIndex();
+	mSettledNum = 0;
+	mUnpackSettledNum = 0;
+	SearchState &state = mQueryState;
+	resetState(state);
+	BinaryHeap<int> candidates;
+	auto relax = [&](int v, double distance, int predecessor, int hop_level)
+	{
+		if (state.stamps[v] != state.stamp || distance < state.distances[v])
+		{
+			state.stamps[v] = state.stamp;
+			state.distances[v] = distance;
+			state.predecessors[v] = predecessor;
+			state.hop_levels[v] = hop_level;
+			candidates.push(distance, v);
+		}
+	};
+	relax(s, 0, -1, 0);
+
+	while (!candidates.empty())
+	{
+		BinaryHeap<int>::Item item = candidates.pop();
+		int v = item.second;
+		if (item.first > state.distances[v])
+		{
+			continue;
+		}
+		++mSettledNum;
+		if (v == t)
+		{
+			break;
+		}
+		int query_level = getQueryLevel(v, s, t);
+		if (query_level == 0)
+		{
+			for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+			{
+				relax(mFlatGraph.outTarget(e), item.first + mvWeights[e], v, 0);
+			}
+			continue;
+		}
+
+		// the clique of the cell of v, then the edges leaving the cell
+		const Level &cur_level = mvLevels[query_level - 1];
+		int cell = cur_level.cell_of[v];
+		const Cell &cur_cell = cur_level.cells[cell];
+		int boundary_num = cur_cell.boundary.size();
+		const double *row = &cur_cell.clique[(size_t)cur_level.boundary_pos[v] * boundary_num];
+		for (int j = 0; j < boundary_num; ++j)
+		{
+			if (row[j] < Graph::DISCONNECT)
+			{
+				relax(cur_cell.boundary[j], item.first + row[j], v, query_level);
+			}
+		}
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			if (cur_level.cell_of[mFlatGraph.outTarget(e)] != cell)
+			{
+				relax(mFlatGraph.outTarget(e), item.first + mvWeights[e], v, 0);
+			}
+		}
+	}
+
+	std::vector<BaseVertex *> vertex_list;
+	if (state.stamps[t] != state.stamp)
+	{
+		return new BasePath(vertex_list, Graph::DISCONNECT);
+	}
+	double weight = state.distances[t];
+
+	// the hops from the target back to the source, then unpacked from the source on
+	std::vector<std::pair<int, int>> hops;
+	for (int v = t; v != s; v = state.predecessors[v])
+	{
+		hops.push_back(std::make_pair(v, state.hop_levels[v]));
+	}
+	std::vector<int> path(1, s);
+	for (std::vector<std::pair<int, int>>::reverse_iterator pos = hops.rbegin(); pos != hops.rend(); ++pos)
+	{
+		if (pos->second == 0)
+		{
+			path.push_back(pos->first);
+		}
+		else
+		{
+			unpackHop(pos->second - 1, path.back(), pos->first, path);
+		}
+	}
+	for (size_t i = 0; i < path.size(); ++i)
+	{
+		vertex_list.push_back(mFlatGraph.getVertex(path[i]));
+	}
+	return new BasePath(vertex_list, weight);
+}
+
+/* The vertices after from up to to of the shortest path between them inside their cell of the given level, appended to vertices */
+void PartitionOverlay::unpackHop(int level, int from, int to, std::vector<int> &vertices)
+{
+	const Level &cur_level = mvLevels[level];
+	int cell = cur_level.cell_of[from];
+	SearchState &state = mUnpackState;
+	resetState(state);
+	BinaryHeap<int> candidates;
+	state.stamps[from] = state.stamp;
+	state.distances[from] = 0;
+	state.predecessors[from] = -1;
+	candidates.push(0, from);
+	while (!candidates.empty())
+	{
+		BinaryHeap<int>::Item item = candidates.pop();
+		int v = item.second;
+		if (item.first > state.distances[v])
+		{
+			continue;
+		}
+		++mUnpackSettledNum;
+		if (v == to)
+		{
+			break;
+		}
+		for (int e = mFlatGraph.outBegin(v); e < mFlatGraph.outEnd(v); ++e)
+		{
+			int u = mFlatGraph.outTarget(e);
+			double distance = item.first + mvWeights[e];
+			if (cur_level.cell_of[u] == cell && (state.stamps[u] != state.stamp || distance < state.distances[u]))
+			{
+				state.stamps[u] = state.stamp;
+				state.distances[u] = distance;
+				state.predecessors[u] = v;
+				candidates.push(distance, u);
+			}
+		}
+	}
+	size_t first_pos = vertices.size();
+	for (int v = to; v != from; v = state.predecessors[v])
+	{
+		vertices.push_back(v);
+	}
+	std::reverse(vertices.begin() + first_pos, vertices.end());
+}
+
+/* A new search: the values of a vertex hold if its stamp is the current one */
+void PartitionOverlay::resetState(SearchState &state) const
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	if ((int)state.stamps.size() != vertex_num)
+	{
+		state.distances.assign(vertex_num, Graph::DISCONNECT);
+		state.predecessors.assign(vertex_num, -1);
+		state.hop_levels.assign(vertex_num, 0);
+		state.stamps.assign(vertex_num, 0);
+		state.stamp = 0;
+	}
+	++state.stamp;
+}
+
+long long PartitionOverlay::getBoundaryVertexNum(int level) const
+{
+	long long boundary_num = 0;
+	for (size_t c = 0; c < mvLevels[level].cells.size(); ++c)
+	{
+		boundary_num += mvLevels[level].cells[c].boundary.size();
+	}
+	return boundary_num;
+}
+
+long long PartitionOverlay::getCliqueEntryNum(int level) const
+{
+	long long entry_num = 0;
+	for (size_t c = 0; c < mvLevels[level].cells.size(); ++c)
+	{
+		entry_num += (long long)mvLevels[level].cells[c].boundary.size() * mvLevels[level].cells[c].boundary.size();
+	}
+	return entry_num;
+}
@@ -0,0 +1,82 @@
+#ifndef __PARTITIONOVERLAY_H__
+#define __PARTITIONOVERLAY_H__
+
+/* Multi-level partition overlay for shortest path queries on weights that change often (customizable route planning).
+The preprocessing is split in two:
+	partition		once per graph: the vertices are cut into cells by recursive BFS bisection, each level
+					cutting the cells of the level above, from the coarsest level down to the finest one
+	customization	once per metric: every cell keeps the distances between its boundary vertices (the ones with an
+					edge to another cell of its level) inside the cell, as a clique matrix. The finest level searches
+					the edges of the cell, every coarser level the cliques of its subcells; the cells of a level are
+					independent and spread over worker threads
+A query is Dijkstra's algorithm that, away from the cells of the source and the target, goes over the cliques of
+the coarsest cell it is in instead of the edges; the clique hops of the result are unpacked by a search inside
+their cell, so that the path is an ordinary path of the graph, e.g. the first path of Yen's algorithm.
+The graph is taken as a snapshot at construction, as in FlatGraph; queries are not thread-safe. */
+class PartitionOverlay
+{
+public:
+	/* cell_sizes: the largest number of vertices of a cell at each level, from the finest level up, e.g. {256, 4096} */
+	PartitionOverlay(Graph &graph, const std::vector<int> &cell_sizes);
+	~PartitionOverlay(void) {}
+
+	/* Clique matrices for the weights of the graph, or for new weights of the fan-out edges in FlatGraph order */
+	void 				customize(int thread_num = 1);
+	void 				customize(const std::vector<double> &edge_weights, int thread_num = 1);
+	/* The shortest path with the last customized weights, unpacked to the vertices of the graph, as Dijkstra::getShortestPath;
+	an empty path of weight Graph::DISCONNECT if there is none. It belongs to the caller. */
+	BasePath*			getShortestPath(BaseVertex* source, BaseVertex* target);
+
+	const FlatGraph& 	getFlatGraph() const 				{ return mFlatGraph; }
+	int 				getLevelNum() const 				{ return mvLevels.size(); }
+	int 				getCellNum(int level) const 		{ return mvLevels[level].cells.size(); }
+	/* Boundary vertices and clique entries of a level, 0 being the finest one */
+	long long 			getBoundaryVertexNum(int level) const;
+	long long 			getCliqueEntryNum(int level) const;
+	/* Vertices settled by the last query on the overlay, and by the searches unpacking its clique hops */
+	int 				getSettledNum() const 				{ return mSettledNum; }
+	int 				getUnpackSettledNum() const 		{ return mUnpackSettledNum; }
+
+private:
+	struct Cell
+	{
+		std::vector<int> 				boundary;
+		/* distance from boundary[i] to boundary[j] inside the cell at [i * boundary.size() + j] */
+		std::vector<double> 			clique;
+	};
+	struct Level
+	{
+		std::vector<int> 				cell_of;
+		/* position of a vertex in the boundary of its cell, -1 inside */
+		std::vector<int> 				boundary_pos;
+		std::vector<Cell> 				cells;
+	};
+	/* Distances and predecessors of one search, reset by stamps; each worker thread has its own */
+	struct SearchState
+	{
+		std::vector<double> 			distances;
+		std::vector<int> 				predecessors;
+		/* 0 if reached by an edge of the graph, the level + 1 of the cell if by a clique hop */
+		std::vector<int> 				hop_levels;
+		std::vector<int> 				stamps;
+		int 							stamp;
+	};
+
+	FlatGraph 							mFlatGraph;
+	std::vector<double> 				mvWeights;
+	std::vector<Level> 					mvLevels;
+	SearchState 						mQueryState;
+	SearchState 						mUnpackState;
+	int 								mSettledNum;
+	int 								mUnpackSettledNum;
+
+	void 				partition(const std::vector<int> &cell_sizes);
+	void 				bisect(const std::vector<int> &vertices, std::vector<int> &first_half, std::vector<int> &second_half,
+							   std::vector<int> &marks, int &mark) const;
+	void 				customizeCell(int level, int cell, SearchState &state);
+	int 				getQueryLevel(int v, int source, int target) const;
+	void 				unpackHop(int level, int from, int to, std::vector<int> &vertices);
+	void 				resetState(SearchState &state) const;
+};
+
+#endif // __PARTITIONOVERLAY_H__
@@ -0,0 +1,60 @@
+#ifndef __PATHCONSTRAINTS_H__
+#define __PATHCONSTRAINTS_H__
+
+/* Rules a path must meet, by node ID: at most max_hop_num edges, a total weight up to max_cost,
+no forbidden vertex or edge, and the via vertices visited in the given order. */
+class PathConstraints
+{
+public:
+	PathConstraints(void) : mMaxHopNum(-1), mMaxCost(Graph::DISCONNECT) {}
+
+	void 					setMaxHopNum(int hop_num) 						{ mMaxHopNum = hop_num; }
+	void 					setMaxCost(double cost) 						{ mMaxCost = cost; }
+	void 					forbidVertex(int node_id) 						{ msForbiddenVertexIds.insert(node_id); }
+	void 					forbidEdge(int start_id, int end_id) 			{ msForbiddenEdges.insert(std::make_pair(start_id, end_id)); }
+	void 					addVia(int node_id) 							{ mvViaIds.push_back(node_id); }
+
+	/* A negative hop number means no limit */
+	int 					getMaxHopNum() const 							{ return mMaxHopNum; }
+	double 					getMaxCost() const 								{ return mMaxCost; }
+	const std::vector<int>& getViaIds() const 								{ return mvViaIds; }
+	bool 					isForbiddenVertex(int node_id) const 			{ return msForbiddenVertexIds.find(node_id) != msForbiddenVertexIds.end(); }
+	bool 					isForbiddenEdge(int start_id, int end_id) const { return msForbiddenEdges.find(std::make_pair(start_id, end_id)) != msForbiddenEdges.end(); }
+	bool 					isEmpty() const
+	{
+		return mMaxHopNum < 0 && mMaxCost >= Graph::DISCONNECT && msForbiddenVertexIds.empty() && msForbiddenEdges.empty() && mvViaIds.empty();
+	}
+
+	/* Check a complete path, e.g. to filter the output of Yen's algorithm */
+	bool isSatisfiedBy(BasePath *path) const
+	{
+		int length = path->length();
+		if ((mMaxHopNum >= 0 && length - 1 > mMaxHopNum) || path->Weight() > mMaxCost)
+		{
+			return false;
+		}
+		size_t via_num = 0;
+		for (int i = 0; i < length; ++i)
+		{
+			int node_id = path->getVertex(i)->getID();
+			if (isForbiddenVertex(node_id) || (i + 1 < length && isForbiddenEdge(node_id, path->getVertex(i + 1)->getID())))
+			{
+				return false;
+			}
+			while (via_num < mvViaIds.size() && mvViaIds[via_num] == node_id)
+			{
+				++via_num;
+			}
+		}
+		return via_num == mvViaIds.size();
+	}
+
+private:
+	int 								mMaxHopNum;
+	double 								mMaxCost;
+	std::set<int> 						msForbiddenVertexIds;
+	std::set<std::pair<int, int>> 		msForbiddenEdges;
+	std::vector<int> 					mvViaIds;
+};
+
+#endif // __PATHCONSTRAINTS_H__
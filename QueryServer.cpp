@@ -0,0 +1,254 @@
+#include <set>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <future>
+#include <string>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "Yen.h"
+#include "MaxFlow.h"
+#include "LineSocket.h"
+#include "QueryServer.h"
+
+/* Fixed threads running the queued tasks; submit() waits while the queue is full. */
+class WorkerPool
+{
+public:
+	WorkerPool(int thread_num, size_t capacity) : mCapacity(capacity), mIsStopping(false)
+	{
+		for (int i = 0; i < thread_num; ++i)
+		{
+			mvThreads.push_back(std::thread(&WorkerPool::loop, this));
+		}
+	}
+	~WorkerPool(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsStopping = true;
+		}
+		mNotEmptyCondition.notify_all();
+		for (size_t i = 0; i < mvThreads.size(); ++i)
+		{
+			mvThreads[i].join();
+		}
+	}
+
+	void submit(const std::function<void()> &task)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mNotFullCondition.wait(lock, [this]() { return mqTasks.size() < mCapacity; });
+			mqTasks.push_back(task);
+		}
+		mNotEmptyCondition.notify_one();
+	}
+
+private:
+	std::vector<std::thread> 				mvThreads;
+	std::deque<std::function<void()>> 		mqTasks;
+	size_t 									mCapacity;
+	std::mutex 								mMutex;
+	std::condition_variable 				mNotEmptyCondition;
+	std::condition_variable 				mNotFullCondition;
+	bool 									mIsStopping;
+
+	void loop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mNotEmptyCondition.wait(lock, [this]() { return mIsStopping || !mqTasks.empty(); });
+				if (mqTasks.empty())
+				{
+					return;
+				}
+				task = mqTasks.front();
+				mqTasks.pop_front();
+			}
+			mNotFullCondition.notify_one();
+			task();
+		}
+	}
+};
+
+QueryServer::QueryServer(Graph &graph, int worker_num, int queue_capacity, int max_k, int max_flow_limit)
+	: mGraph(graph), mMaxK(max_k), mIsMaxFlowEnabled(graph.getVertexNum() <= max_flow_limit)
+{
+	if (mIsMaxFlowEnabled)
+	{
+		PushRelabel_capacities(mGraph, mvCapacities);
+	}
+	mpWorkerPool = new WorkerPool(std::max(1, worker_num), std::max(1, queue_capacity));
+}
+
+QueryServer::~QueryServer(void)
+{
+	delete mpWorkerPool;
+}
+
+void QueryServer::serve(int listen_fd)
+{
+	while (true)
+	{
+		int fd = LineSocket::acceptConnection(listen_fd);
+		if (fd < 0)
+		{
+			std::cerr << "The server can not accept connections any more." << std::endl;
+			return;
+		}
+		std::thread(&QueryServer::handleConnection, this, fd).detach();
+	}
+}
+
+/* The reader queues the requests to the worker pool as they come, up to MAX_PENDING_NUM answers not written yet;
+the writer sends the answers back in the order of the requests, waiting for each one in turn. */
+void QueryServer::handleConnection(int fd)
+{
+	LineSocket socket(fd);
+	std::mutex pending_mutex;
+	std::condition_variable pending_condition;
+	std::deque<std::shared_future<std::string>> pending_answers;
+	bool is_read_done = false;
+
+	std::thread writer([&]() {
+		bool is_connected = true;
+		while (true)
+		{
+			std::shared_future<std::string> answer;
+			{
+				std::unique_lock<std::mutex> lock(pending_mutex);
+				pending_condition.wait(lock, [&]() { return is_read_done || !pending_answers.empty(); });
+				if (pending_answers.empty())
+				{
+					return;
+				}
+				answer = pending_answers.front();
+				pending_answers.pop_front();
+			}
+			pending_condition.notify_one();
+			// once the client is gone, the queued requests are still waited for, their answers dropped
+			is_connected = is_connected && socket.writeAll(answer.get() + "\n");
+		}
+	});
+
+	std::string line;
+	long long request_id = 0;
+	while (socket.readLine(line))
+	{
+		if (line.find_first_not_of(" \t") == std::string::npos)
+		{
+			continue;
+		}
+		std::shared_ptr<std::packaged_task<std::string()>> task =
+			std::make_shared<std::packaged_task<std::string()>>(std::bind(&QueryServer::answer, this, line, request_id++));
+		{
+			// a client that does not read its answers stops the reading of its requests
+			std::unique_lock<std::mutex> lock(pending_mutex);
+			pending_condition.wait(lock, [&]() { return pending_answers.size() < (size_t)MAX_PENDING_NUM; });
+			pending_answers.push_back(task->get_future().share());
+		}
+		pending_condition.notify_one();
+		mpWorkerPool->submit([task]() { (*task)(); });
+	}
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		is_read_done = true;
+	}
+	pending_condition.notify_one();
+	writer.join();
+}
+
+std::string QueryServer::errorAnswer(long long request_id, const std::string &message)
+{
+	std::ostringstream oss;
+	oss << "{\"id\":" << request_id << ",\"error\":\"" << message << "\"}";
+	return oss.str();
+}
+
+std::string QueryServer::answer(const std::string &request, long long request_id)
+{
+	std::istringstream iss(request);
+	std::string command;
+	int source_id, target_id;
+	iss >> command;
+	if (command != "KSP" && command != "MAXFLOW")
+	{
+		return errorAnswer(request_id, "unknown command");
+	}
+	if (!(iss >> source_id >> target_id))
+	{
+		return errorAnswer(request_id, "missing vertex");
+	}
+
+	// the shared graph is only read: a vertex is looked up without being created
+	int source_index = mGraph.getInternalIndex(source_id);
+	int target_index = mGraph.getInternalIndex(target_id);
+	if (source_index < 0 || target_index < 0)
+	{
+		return errorAnswer(request_id, "unknown vertex " + std::to_string(source_index < 0 ? source_id : target_id));
+	}
+	BaseVertex *source = mGraph.getVertexList()[source_index];
+	BaseVertex *target = mGraph.getVertexList()[target_index];
+
+	if (command == "MAXFLOW")
+	{
+		return answerMaxFlow(source, target, request_id);
+	}
+	int top_k = 0;
+	if (!(iss >> top_k) || top_k < 1 || top_k > mMaxK)
+	{
+		return errorAnswer(request_id, "k must be between 1 and " + std::to_string(mMaxK));
+	}
+	return answerPaths(source, target, top_k, request_id);
+}
+
+std::string QueryServer::answerPaths(BaseVertex *source, BaseVertex *target, int top_k, long long request_id)
+{
+	Yen yen_alg(mGraph, NULL, NULL);
+	std::vector<BasePath *> result_list;
+	yen_alg.getShortestPaths(source, target, top_k, result_list);
+
+	std::ostringstream oss;
+	oss.precision(12);
+	oss << "{\"id\":" << request_id << ",\"paths\":[";
+	for (size_t i = 0; i < result_list.size(); ++i)
+	{
+		oss << (i > 0 ? "," : "") << "{\"distance\":" << result_list[i]->Weight() << ",\"nodes\":[";
+		for (int j = 0; j < result_list[i]->length(); ++j)
+		{
+			oss << (j > 0 ? "," : "") << result_list[i]->getVertex(j)->getID();
+		}
+		oss << "]}";
+	}
+	oss << "]}";
+	return oss.str();
+}
+
+std::string QueryServer::answerMaxFlow(BaseVertex *source, BaseVertex *target, long long request_id)
+{
+	if (!mIsMaxFlowEnabled)
+	{
+		return errorAnswer(request_id, "the graph is too large for the max flow");
+	}
+	if (source == target)
+	{
+		return errorAnswer(request_id, "the source is the target");
+	}
+	// the max flow consumes its capacity matrix
+	std::vector<std::vector<int>> capacity(mvCapacities);
+	std::ostringstream oss;
+	oss << "{\"id\":" << request_id << ",\"flow\":" << PushRelabel_FIFO(capacity, source->getIndex(), target->getIndex()) << "}";
+	return oss.str();
+}
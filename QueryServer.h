@@ -0,0 +1,47 @@
+#ifndef __QUERYSERVER_H__
+#define __QUERYSERVER_H__
+
+class WorkerPool;
+
+/* Long-lived query server on a graph loaded once (POSIX only).
+A client sends one request per line and may send the next ones before the answers come back:
+	KSP <source_id> <target_id> <k>		the top k shortest paths
+	MAXFLOW <source_id> <target_id>		the max flow, capacities as in PushRelabel_capacities
+Every request gets one line of JSON, in the order of the requests of the connection, with the position
+of the request on the connection as id:
+	{"id":0,"paths":[{"distance":0.143528,"nodes":[3,39,40]}]}
+	{"id":1,"flow":42}
+	{"id":2,"error":"unknown vertex 99"}
+The requests of all connections are answered by a bounded pool of worker threads: when its queue is full,
+the connections stop reading until a worker is free. A connection also stops reading while MAX_PENDING_NUM
+of its answers are not written yet, so that a client that does not read its answers holds a bounded memory. */
+class QueryServer
+{
+public:
+	static const int 	MAX_PENDING_NUM = 64;
+
+	/* The max flow works on a dense capacity matrix, it is answered up to max_flow_limit vertices */
+	QueryServer(Graph &graph, int worker_num, int queue_capacity, int max_k, int max_flow_limit);
+	~QueryServer(void);
+
+	/* Accept and serve connections until the process ends */
+	void 			serve(int listen_fd);
+	/* Answer one request line */
+	std::string 	answer(const std::string &request, long long request_id);
+	/* The answer line of a request that fails, also for the requests the batch runner gives up on */
+	static std::string 	errorAnswer(long long request_id, const std::string &message);
+
+protected:
+	void 			handleConnection(int fd);
+	std::string 	answerPaths(BaseVertex* source, BaseVertex* target, int top_k, long long request_id);
+	std::string 	answerMaxFlow(BaseVertex* source, BaseVertex* target, long long request_id);
+
+private:
+	Graph& 								mGraph;
+	WorkerPool* 						mpWorkerPool;
+	int 								mMaxK;
+	bool 								mIsMaxFlowEnabled;
+	std::vector<std::vector<int>> 		mvCapacities;
+};
+
+#endif // __QUERYSERVER_H__
@@ -0,0 +1,235 @@
+#include <set>
+#include <map>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "FlatGraph.h"
+#include "Dijkstra.h"
+#include "MonotoneQueue.h"
+#include "SearchKernel.h"
+
+/* The predecessors lead back to the start vertex: against the edges forward, along them backward */
+BasePath *SearchKernelBase::getPath(int v) const
+{
+	const FlatGraph &flat_graph = getFlatGraph();
+	std::vector<BaseVertex *> vertex_list;
+	double weight = getDistance(v);
+	if (weight < Graph::DISCONNECT)
+	{
+		for (int u = v; u >= 0; u = getPredecessor(u))
+		{
+			vertex_list.push_back(flat_graph.getVertex(u));
+		}
+		if (getDirection() == SEARCH_FORWARD)
+		{
+			std::reverse(vertex_list.begin(), vertex_list.end());
+		}
+	}
+	return new BasePath(vertex_list, weight);
+}
+
+void SearchKernelBase::exportTo(Dijkstra &dijkstra) const
+{
+	const FlatGraph &flat_graph = getFlatGraph();
+	dijkstra.clear();
+	for (int v = 0; v < flat_graph.getVertexNum(); ++v)
+	{
+		double distance = getDistance(v);
+		if (distance < Graph::DISCONNECT)
+		{
+			dijkstra.setStartDistanceAt(flat_graph.getVertex(v), distance);
+			if (getPredecessor(v) >= 0)
+			{
+				dijkstra.setPredecessorVertex(flat_graph.getVertex(v), flat_graph.getVertex(getPredecessor(v)));
+			}
+		}
+	}
+}
+
+RuntimeSearchKernel::RuntimeSearchKernel(Graph &graph, SearchDirection direction, WeightType weight_type, QueueType queue_type, double weight_unit)
+	: mFlatGraph(graph), mDirection(direction), mWeightType(weight_type), mQueueType(queue_type), mWeightUnit(weight_unit),
+	  mMaxWeight(0), mSettledNum(0), mStamp(0)
+{
+	int vertex_num = mFlatGraph.getVertexNum();
+	for (int e = 0; e < mFlatGraph.getEdgeNum(); ++e)
+	{
+		double weight = direction == SEARCH_FORWARD ? mFlatGraph.outWeight(e) : mFlatGraph.inWeight(e);
+		if (weight_type == WEIGHT_INT)
+		{
+			mvIntWeights.push_back((unsigned int)llround(weight / weight_unit));
+			mMaxWeight = std::max(mMaxWeight, (unsigned long long)mvIntWeights.back());
+		}
+		else if (weight_type == WEIGHT_FLOAT)
+		{
+			mvFloatWeights.push_back((float)weight);
+		}
+		else
+		{
+			mvDoubleWeights.push_back(weight);
+		}
+	}
+	mvDistances.assign(vertex_num, 0);
+	mvIntDistances.assign(vertex_num, 0);
+	mvPredecessors.assign(vertex_num, -1);
+	mvReachedStamp.assign(vertex_num, 0);
+	mvSettledStamp.assign(vertex_num, 0);
+}
+
+void RuntimeSearchKernel::search(int start, int end)
+{
+	++mStamp;
+	mSettledNum = 0;
+	bool is_int = mWeightType == WEIGHT_INT;
+	BinaryHeap<int> heap;
+	BinaryHeap<int, unsigned long long> int_heap;
+	BucketQueue<int> buckets(mQueueType == QUEUE_BUCKET ? mMaxWeight : 0);
+	RadixHeap<int> radix_heap;
+
+	// every queue operation goes to the queue of the run-time type
+	auto push = [&](double key, unsigned long long int_key, int v) {
+		if (mQueueType == QUEUE_BUCKET)
+		{
+			buckets.push(int_key, v);
+		}
+		else if (mQueueType == QUEUE_RADIX)
+		{
+			radix_heap.push(int_key, v);
+		}
+		else if (is_int)
+		{
+			int_heap.push(int_key, v);
+		}
+		else
+		{
+			heap.push(key, v);
+		}
+	};
+	auto isEmpty = [&]() {
+		return mQueueType == QUEUE_BUCKET ? buckets.empty() : (mQueueType == QUEUE_RADIX ? radix_heap.empty() : (is_int ? int_heap.empty() : heap.empty()));
+	};
+	auto pop = [&](double &key, unsigned long long &int_key) {
+		std::pair<unsigned long long, int> int_item;
+		if (mQueueType == QUEUE_BUCKET)
+		{
+			int_item = buckets.pop();
+		}
+		else if (mQueueType == QUEUE_RADIX)
+		{
+			int_item = radix_heap.pop();
+		}
+		else if (is_int)
+		{
+			int_item = int_heap.pop();
+		}
+		else
+		{
+			std::pair<double, int> item = heap.pop();
+			key = item.first;
+			return item.second;
+		}
+		int_key = int_item.first;
+		return int_item.second;
+	};
+
+	mvReachedStamp[start] = mStamp;
+	mvDistances[start] = 0;
+	mvIntDistances[start] = 0;
+	mvPredecessors[start] = -1;
+	push(0, 0, start);
+	while (!isEmpty())
+	{
+		double key = 0;
+		unsigned long long int_key = 0;
+		int v = pop(key, int_key);
+		if (mvSettledStamp[v] == mStamp || (is_int ? int_key > mvIntDistances[v] : key > mvDistances[v]))
+		{
+			continue;
+		}
+		mvSettledStamp[v] = mStamp;
+		++mSettledNum;
+		if (v == end)
+		{
+			break;
+		}
+		int edge_end = mDirection == SEARCH_FORWARD ? mFlatGraph.outEnd(v) : mFlatGraph.inEnd(v);
+		for (int e = mDirection == SEARCH_FORWARD ? mFlatGraph.outBegin(v) : mFlatGraph.inBegin(v); e < edge_end; ++e)
+		{
+			int u = mDirection == SEARCH_FORWARD ? mFlatGraph.outTarget(e) : mFlatGraph.inSource(e);
+			bool is_reached = mvReachedStamp[u] == mStamp;
+			if (is_int)
+			{
+				unsigned long long distance = int_key + mvIntWeights[e];
+				if (is_reached && distance >= mvIntDistances[u])
+				{
+					continue;
+				}
+				mvIntDistances[u] = distance;
+				push(0, distance, u);
+			}
+			else
+			{
+				double distance = key + (mWeightType == WEIGHT_FLOAT ? mvFloatWeights[e] : mvDoubleWeights[e]);
+				if (is_reached && distance >= mvDistances[u])
+				{
+					continue;
+				}
+				mvDistances[u] = distance;
+				push(distance, 0, u);
+			}
+			mvReachedStamp[u] = mStamp;
+			mvPredecessors[u] = v;
+		}
+	}
+}
+
+double RuntimeSearchKernel::getDistance(int v) const
+{
+	if (mvReachedStamp[v] != mStamp)
+	{
+		return Graph::DISCONNECT;
+	}
+	return mWeightType == WEIGHT_INT ? mvIntDistances[v] * mWeightUnit : mvDistances[v];
+}
+
+std::string RuntimeSearchKernel::getName() const
+{
+	const char *weight_names[] = {"double", "float", "int"};
+	const char *queue_names[] = {"heap", "bucket", "radix"};
+	return std::string("runtime/") + (mDirection == SEARCH_FORWARD ? "forward/" : "backward/") + weight_names[mWeightType] + "/" + queue_names[mQueueType];
+}
+
+template <SearchDirection Direction>
+static SearchKernelBase *createDirectedSearchKernel(Graph &graph)
+{
+	if (graph.isQuantized())
+	{
+		if (graph.getMaxIntEdgeWeight() <= Dijkstra::MAX_BUCKET_WEIGHT)
+		{
+			return new SearchKernel<Direction, unsigned int, BucketQueue<int>>(graph, graph.getWeightUnit());
+		}
+		if (graph.getMaxIntEdgeWeight() <= UINT_MAX)
+		{
+			return new SearchKernel<Direction, unsigned int, RadixHeap<int>>(graph, graph.getWeightUnit());
+		}
+		return new SearchKernel<Direction, unsigned long long, RadixHeap<int>>(graph, graph.getWeightUnit());
+	}
+	// the compact mode keeps float weights: the distances are the same in double with half of the edge bytes
+	if (graph.isCompact())
+	{
+		return new SearchKernel<Direction, float, BinaryHeap<int>>(graph);
+	}
+	return new SearchKernel<Direction, double, BinaryHeap<int>>(graph);
+}
+
+SearchKernelBase *createSearchKernel(Graph &graph, SearchDirection direction)
+{
+	if (direction == SEARCH_FORWARD)
+	{
+		return createDirectedSearchKernel<SEARCH_FORWARD>(graph);
+	}
+	return createDirectedSearchKernel<SEARCH_BACKWARD>(graph);
+}
@@ -0,0 +1,326 @@
+#ifndef __SEARCHKERNEL_H__
+#define __SEARCHKERNEL_H__
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+class Dijkstra;
+
+/* Dijkstra's search on a FlatGraph, compiled once per direction, edge weight type and queue policy.
+Dijkstra::improve2Vertex decides the direction and the weight mode at every edge and goes through the maps of the graph;
+here they are template parameters resolved with if constexpr, so that each instantiation is one loop over the packed
+edges of a vertex. createSearchKernel picks the instantiation matching a graph, once per query.
+The graph is taken as a snapshot at construction: vertices and edges removed from it are left out, as in FlatGraph. */
+
+enum SearchDirection { SEARCH_FORWARD, SEARCH_BACKWARD };
+
+/* Binary heap with the interface of the monotone queues of MonotoneQueue.h, for keys of any type and no monotony.
+The smallest key is on top. The sifts are written out rather than taken from std::priority_queue: inlined into a kernel,
+its sift-down picks the smaller child with a branch, which random keys mispredict half of the time. */
+template <class T, class Key = double>
+class BinaryHeap
+{
+public:
+	typedef std::pair<Key, T> 	Item;
+
+	bool 	empty() const 										{ return mvEntries.empty(); }
+	size_t 	size() const 										{ return mvEntries.size(); }
+	void 	push(Key key, const T &value)
+	{
+		// the parents larger than the key move down a level
+		size_t i = mvEntries.size();
+		mvEntries.push_back(Item(key, value));
+		while (i > 0 && key < mvEntries[(i - 1) / 2].first)
+		{
+			mvEntries[i] = mvEntries[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		mvEntries[i] = Item(key, value);
+	}
+	Item 	pop()
+	{
+		Item item = mvEntries.front();
+		Item last = mvEntries.back();
+		mvEntries.pop_back();
+		size_t entry_num = mvEntries.size();
+		if (entry_num == 0)
+		{
+			return item;
+		}
+		// the smaller children move up a level; the right child is chosen by adding the comparison, not by a branch
+		size_t i = 0;
+		for (size_t child = 1; child < entry_num; child = 2 * i + 1)
+		{
+			child += child + 1 < entry_num && mvEntries[child + 1].first < mvEntries[child].first;
+			if (!(mvEntries[child].first < last.first))
+			{
+				break;
+			}
+			mvEntries[i] = mvEntries[child];
+			i = child;
+		}
+		mvEntries[i] = last;
+		return item;
+	}
+
+private:
+	std::vector<Item> 	mvEntries;
+};
+
+/* What a query needs of any instantiation; the virtual calls are per query, never per edge.
+Vertices are addressed by their dense index (BaseVertex::getIndex()). */
+class SearchKernelBase
+{
+public:
+	virtual ~SearchKernelBase(void) {}
+
+	/* Distances from the start vertex (forward) or to it (backward), up to the end vertex, or of every vertex for -1 */
+	virtual void 				search(int start, int end = -1) = 0;
+	/* Distance in km of a vertex settled or reached by the last search, Graph::DISCONNECT otherwise */
+	virtual double 				getDistance(int v) const = 0;
+	/* The next vertex towards the start vertex, -1 for the start vertex and the vertices not reached */
+	virtual int 				getPredecessor(int v) const = 0;
+	virtual int 				getSettledNum() const = 0;
+	virtual const FlatGraph& 	getFlatGraph() const = 0;
+	/* e.g. "backward/float/heap" */
+	virtual std::string 		getName() const = 0;
+
+	virtual SearchDirection 	getDirection() const = 0;
+
+	/* The path between the start vertex and a vertex reached by the last search, in the direction of the edges,
+	an empty one if not reached, as Dijkstra::getShortestPath; it belongs to the caller */
+	BasePath* 					getPath(int v) const;
+	/* Hand the tree over to a Dijkstra object, as DeltaStepping::exportTo, e.g. for the cost updates of Yen's algorithm */
+	void 						exportTo(Dijkstra &dijkstra) const;
+};
+
+/* Weight is the type of the edge weights: double, float, or an unsigned integer type counting weight units,
+which makes the distances unsigned long long, as in the integer weight mode of Dijkstra.
+Queue is BinaryHeap, or BucketQueue or RadixHeap for the integer weights. */
+template <SearchDirection Direction, class Weight, class Queue>
+class SearchKernel : public SearchKernelBase
+{
+public:
+	typedef typename std::conditional<std::is_integral<Weight>::value, unsigned long long, double>::type 	Distance;
+
+	/* The weight unit in km is needed by the integer weights only, the weights of the graph are rounded to it */
+	SearchKernel(Graph &graph, double weight_unit = 0)
+		: mFlatGraph(graph), mWeightUnit(weight_unit), mMaxWeight(0), mSettledNum(0), mStamp(0)
+	{
+		int vertex_num = mFlatGraph.getVertexNum();
+		mvWeights.resize(mFlatGraph.getEdgeNum());
+		for (int e = 0; e < mFlatGraph.getEdgeNum(); ++e)
+		{
+			double weight = Direction == SEARCH_FORWARD ? mFlatGraph.outWeight(e) : mFlatGraph.inWeight(e);
+			if constexpr (std::is_integral<Weight>::value)
+			{
+				mvWeights[e] = (Weight)llround(weight / weight_unit);
+			}
+			else
+			{
+				mvWeights[e] = (Weight)weight;
+			}
+			mMaxWeight = std::max(mMaxWeight, (unsigned long long)mvWeights[e]);
+		}
+		mvDistances.assign(vertex_num, Distance());
+		mvPredecessors.assign(vertex_num, -1);
+		mvReachedStamp.assign(vertex_num, 0);
+		mvSettledStamp.assign(vertex_num, 0);
+	}
+
+	void 				search(int start, int end = -1)
+	{
+		++mStamp;
+		Queue candidates = makeQueue();
+		reach(start, Distance(), -1);
+		candidates.push(Distance(), start);
+
+		// the arrays and the stamp in locals: a push may reallocate the queue in a call the compiler does not see
+		// through, after which every member would be read again at each edge
+		const int *offsets = edgeOffsets();
+		const int *neighbors = edgeNeighbors();
+		const Weight *weights = mvWeights.data();
+		Distance *distances = mvDistances.data();
+		int *predecessors = mvPredecessors.data();
+		int *reached_stamps = mvReachedStamp.data();
+		int *settled_stamps = mvSettledStamp.data();
+		int stamp = mStamp;
+		int settled_num = 0;
+
+		// improved vertices are queued again, outdated entries are skipped when popped
+		while (!candidates.empty())
+		{
+			typename Queue::Item item = candidates.pop();
+			int v = item.second;
+			if (settled_stamps[v] == stamp || item.first > distances[v])
+			{
+				continue;
+			}
+			settled_stamps[v] = stamp;
+			++settled_num;
+			if (v == end)
+			{
+				break;
+			}
+			for (int e = offsets[v], edge_end = offsets[v + 1]; e < edge_end; ++e)
+			{
+				int u = neighbors[e];
+				Distance distance = item.first + weights[e];
+				if (reached_stamps[u] != stamp || distance < distances[u])
+				{
+					reached_stamps[u] = stamp;
+					distances[u] = distance;
+					predecessors[u] = v;
+					candidates.push(distance, u);
+				}
+			}
+		}
+		mSettledNum = settled_num;
+	}
+
+	double 				getDistance(int v) const
+	{
+		if (mvReachedStamp[v] != mStamp)
+		{
+			return Graph::DISCONNECT;
+		}
+		if constexpr (std::is_integral<Weight>::value)
+		{
+			return mvDistances[v] * mWeightUnit;
+		}
+		else
+		{
+			return mvDistances[v];
+		}
+	}
+	int 				getPredecessor(int v) const 			{ return mvReachedStamp[v] == mStamp ? mvPredecessors[v] : -1; }
+	int 				getSettledNum() const 					{ return mSettledNum; }
+	const FlatGraph& 	getFlatGraph() const 					{ return mFlatGraph; }
+	SearchDirection 	getDirection() const 					{ return Direction; }
+	std::string 		getName() const
+	{
+		std::string name = Direction == SEARCH_FORWARD ? "forward/" : "backward/";
+		if constexpr (std::is_integral<Weight>::value)
+		{
+			name += "int/";
+		}
+		else
+		{
+			name += std::is_same<Weight, float>::value ? "float/" : "double/";
+		}
+		if constexpr (std::is_same<Queue, BucketQueue<int>>::value)
+		{
+			return name + "bucket";
+		}
+		else
+		{
+			return name + (std::is_same<Queue, RadixHeap<int>>::value ? "radix" : "heap");
+		}
+	}
+
+private:
+	FlatGraph 						mFlatGraph;
+	double 							mWeightUnit;
+	unsigned long long 				mMaxWeight;
+	std::vector<Weight> 			mvWeights;
+	/* Search state: a vertex is reached or settled by the last search if its stamp is the current one */
+	std::vector<Distance> 			mvDistances;
+	std::vector<int> 				mvPredecessors;
+	std::vector<int> 				mvReachedStamp;
+	std::vector<int> 				mvSettledStamp;
+	int 							mSettledNum;
+	int 							mStamp;
+
+	/* Dial's buckets are sized by the largest weight, the other queues take no argument */
+	Queue 				makeQueue() const
+	{
+		if constexpr (std::is_constructible<Queue, unsigned long long>::value)
+		{
+			return Queue(mMaxWeight);
+		}
+		else
+		{
+			return Queue();
+		}
+	}
+	/* The offsets and the neighbors of the direction */
+	const int* 			edgeOffsets() const
+	{
+		if constexpr (Direction == SEARCH_FORWARD)
+		{
+			return mFlatGraph.getOutOffsets();
+		}
+		else
+		{
+			return mFlatGraph.getInOffsets();
+		}
+	}
+	const int* 			edgeNeighbors() const
+	{
+		if constexpr (Direction == SEARCH_FORWARD)
+		{
+			return mFlatGraph.getOutTargets();
+		}
+		else
+		{
+			return mFlatGraph.getInSources();
+		}
+	}
+	void 				reach(int v, Distance distance, int predecessor)
+	{
+		mvReachedStamp[v] = mStamp;
+		mvDistances[v] = distance;
+		mvPredecessors[v] = predecessor;
+	}
+};
+
+/* The baseline of the kernels: the same loop over the same FlatGraph, with the direction, the weight type and the queue
+tested at every edge and at every queue operation, as Dijkstra::improve2Vertex tests them. Compared with it, a kernel shows
+what the compile-time specialization saves apart from the packed edges. */
+class RuntimeSearchKernel : public SearchKernelBase
+{
+public:
+	enum WeightType { WEIGHT_DOUBLE, WEIGHT_FLOAT, WEIGHT_INT };
+	enum QueueType { QUEUE_HEAP, QUEUE_BUCKET, QUEUE_RADIX };
+
+	/* As SearchKernel: the weight unit is needed by the integer weights only; the buckets and the radix heap need them */
+	RuntimeSearchKernel(Graph &graph, SearchDirection direction, WeightType weight_type, QueueType queue_type, double weight_unit = 0);
+
+	void 				search(int start, int end = -1);
+	double 				getDistance(int v) const;
+	int 				getPredecessor(int v) const 			{ return mvReachedStamp[v] == mStamp ? mvPredecessors[v] : -1; }
+	int 				getSettledNum() const 					{ return mSettledNum; }
+	const FlatGraph& 	getFlatGraph() const 					{ return mFlatGraph; }
+	SearchDirection 	getDirection() const 					{ return mDirection; }
+	/* e.g. "runtime/backward/float/heap" */
+	std::string 		getName() const;
+
+private:
+	FlatGraph 						mFlatGraph;
+	SearchDirection 				mDirection;
+	WeightType 						mWeightType;
+	QueueType 						mQueueType;
+	double 							mWeightUnit;
+	unsigned long long 				mMaxWeight;
+	/* Only the weights of the weight type are filled */
+	std::vector<double> 			mvDoubleWeights;
+	std::vector<float> 				mvFloatWeights;
+	std::vector<unsigned int> 		mvIntWeights;
+	/* Search state, as in SearchKernel; the integer weights use mvIntDistances, the others mvDistances */
+	std::vector<double> 			mvDistances;
+	std::vector<unsigned long long> mvIntDistances;
+	std::vector<int> 				mvPredecessors;
+	std::vector<int> 				mvReachedStamp;
+	std::vector<int> 				mvSettledStamp;
+	int 							mSettledNum;
+	int 							mStamp;
+};
+
+/* The instantiation for the weight mode of a graph: integer weights with Dial's buckets or a radix heap as Dijkstra does,
+the float weights of the compact mode, or double weights, all of them giving the distances of Dijkstra. The caller deletes it. */
+SearchKernelBase* createSearchKernel(Graph &graph, SearchDirection direction);
+
+#endif // __SEARCHKERNEL_H__
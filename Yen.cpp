@@ -2,30 +2,72 @@
 #include <map>
 #include <queue>
 #include <vector>
+#include <algorithm>
 #include "BaseGraph.h"
 #include "Graph.h"
 #include "Dijkstra.h"
+#include "FlatGraph.h"
+#include "DeltaStepping.h"
+#include "MonotoneQueue.h"
+#include "SearchKernel.h"
 #include "Yen.h"
+#include "Instrument.h"
 
+Yen::~Yen(void)
+{
+	clear();
+	delete mpTreeBuilder;
+	delete mpReverseTree;
+	delete mpGraph;
+}
+
+/* The paths returned so far are deleted as well */
 void Yen::clear()
 {
 	mGeneratedPathNum = 0;
+	mRepairedVertexNum = 0;
+	mRemainingPathNum = -1;
+	delete mpReverseTree;
+	mpReverseTree = NULL;
+	mvTreeChildren.clear();
 	mmDerivationVertexIndex.clear();
+	for_each(mvResultList.begin(), mvResultList.end(), DeleteFunc<BasePath>());
 	mvResultList.clear();
+	for_each(mqPathCandidates.begin(), mqPathCandidates.end(), DeleteFunc<BasePath>());
 	mqPathCandidates.clear();
 }
 
-void Yen::initialize()
+void Yen::initialize(BasePath *pShortestPath)
 {
 	clear();
-	if (mpSourceVertex != NULL && mpTargetVertex != NULL)
+	BasePath *pFirstPath = NULL;
+	if (pShortestPath != NULL)
 	{
-		BasePath *pShortestPath = getShortestPath(mpSourceVertex, mpTargetVertex);
-		if (pShortestPath != NULL && pShortestPath->length() > 1)
+		// an empty path, for no path at all, leaves no candidate
+		std::vector<BaseVertex *> vertex_list;
+		for (int i = 0; i < pShortestPath->length(); ++i)
 		{
-			mqPathCandidates.insert(pShortestPath);
-			mmDerivationVertexIndex[pShortestPath] = mpSourceVertex;
+			vertex_list.push_back(pShortestPath->getVertex(i));
 		}
+		if (!vertex_list.empty())
+		{
+			mpSourceVertex = vertex_list.front();
+			mpTargetVertex = vertex_list.back();
+		}
+		pFirstPath = new BasePath(vertex_list, pShortestPath->Weight());
+	}
+	else if (mpSourceVertex != NULL && mpTargetVertex != NULL)
+	{
+		pFirstPath = getShortestPath(mpSourceVertex, mpTargetVertex);
+	}
+	if (pFirstPath != NULL && pFirstPath->length() > 1)
+	{
+		mqPathCandidates.insert(pFirstPath);
+		mmDerivationVertexIndex[pFirstPath] = mpSourceVertex;
+	}
+	else
+	{
+		delete pFirstPath;
 	}
 }
 
@@ -40,8 +82,87 @@ bool Yen::hasNext()
 	return !mqPathCandidates.empty();
 }
 
+void Yen::buildReverseTree(Dijkstra &reverse_tree)
+{
+	INSTRUMENT_SCOPE(REVERSE_TREE);
+	if (mpTreeBuilder != NULL)
+	{
+		mpTreeBuilder->getShortestPathFlower(mpTargetVertex);
+		mpTreeBuilder->exportTo(reverse_tree);
+	}
+	else if (mIsKernelSearch)
+	{
+		// the instantiation is picked once per tree, its snapshot leaves out what is removed from the graph
+		SearchKernelBase *kernel = createSearchKernel(*mpGraph, SEARCH_BACKWARD);
+		kernel->search(mpTargetVertex->getIndex());
+		kernel->exportTo(reverse_tree);
+		delete kernel;
+	}
+	else
+	{
+		reverse_tree.getShortestPathFlower(mpTargetVertex);
+	}
+}
+
+/* Search again the vertices of the tree below the removed vertices of the current path, every removed edge leaving one of them.
+The tree distances only grow with the removals: a vertex farther than max_distance on the whole graph is left out. */
+void Yen::repairReverseTree(BasePath *cur_path, double max_distance)
+{
+	INSTRUMENT_SCOPE(REVERSE_TREE);
+	++mTreeStamp;
+	std::vector<BaseVertex *> affected_vertices;
+	std::vector<BaseVertex *> vertex_stack;
+	for (int i = 0; i < cur_path->length() - 1; ++i)
+	{
+		vertex_stack.push_back(cur_path->getVertex(i));
+		while (!vertex_stack.empty())
+		{
+			BaseVertex *cur_vertex_pt = vertex_stack.back();
+			vertex_stack.pop_back();
+			int v = cur_vertex_pt->getIndex();
+			if (mvTreeStamp[v] == mTreeStamp || mpReverseTree->getStartDistanceAt(cur_vertex_pt) > max_distance)
+			{
+				continue;
+			}
+			mvTreeStamp[v] = mTreeStamp;
+			affected_vertices.push_back(cur_vertex_pt);
+			vertex_stack.insert(vertex_stack.end(), mvTreeChildren[v].begin(), mvTreeChildren[v].end());
+		}
+	}
+	mRepairedVertexNum += affected_vertices.size();
+	mpReverseTree->startJournal();
+	mpReverseTree->repairFlower(affected_vertices, max_distance);
+}
+
 BasePath *Yen::next()
 {
+	INSTRUMENT_SCOPE(YEN_NEXT);
+	INSTRUMENT_COUNT(YEN_ITERATIONS);
+
+	// the parallel tree builder takes its snapshot of the graph while nothing is removed
+	if (mThreadNum > 1 && mpTreeBuilder == NULL)
+	{
+		mpTreeBuilder = new DeltaStepping(mpGraph, mThreadNum);
+	}
+	if (mIsTreeReused && mpReverseTree == NULL)
+	{
+		// built on the whole graph before any removal, with the children of every vertex to find its subtree
+		mpReverseTree = new Dijkstra(mpGraph);
+		buildReverseTree(*mpReverseTree);
+		const std::vector<BaseVertex *> &vertices = mpGraph->getVertexList();
+		mvTreeChildren.assign(vertices.size(), std::vector<BaseVertex *>());
+		mvTreeStamp.assign(vertices.size(), 0);
+		mTreeStamp = 0;
+		for (size_t v = 0; v < vertices.size(); ++v)
+		{
+			BaseVertex *successor = vertices[v] == mpTargetVertex ? NULL : mpReverseTree->getPredecessorVertex(vertices[v]);
+			if (successor != NULL)
+			{
+				mvTreeChildren[successor->getIndex()].push_back(vertices[v]);
+			}
+		}
+	}
+
 	// prepare for removing vertices and arcs
 	BasePath *cur_path = *(mqPathCandidates.begin()); // mqPathCandidates.top();
 
@@ -54,6 +175,19 @@ BasePath *Yen::next()
 	cur_path->subPath(sub_path_of_derivation_pt, cur_derivation_pt);
 	int sub_path_length = sub_path_of_derivation_pt.size();
 
+	// with k known, the candidates beyond the paths still to return are of no use
+	if (mRemainingPathNum > 0 && --mRemainingPathNum == 0)
+	{
+		return cur_path;
+	}
+	double max_cost = Graph::DISCONNECT;
+	if (mRemainingPathNum > 0 && (int)mqPathCandidates.size() >= mRemainingPathNum)
+	{
+		std::multiset<BasePath *, WeightLess<BasePath>>::const_iterator pos = mqPathCandidates.begin();
+		std::advance(pos, mRemainingPathNum - 1);
+		max_cost = (*pos)->Weight();
+	}
+
 	// remove the vertices and arcs in the graph
 	for (int i = 0; i < count - 1; ++i)
 	{
@@ -92,9 +226,30 @@ BasePath *Yen::next()
 		mpGraph->removeEdge(std::make_pair(cur_path->getVertex(i)->getID(), cur_path->getVertex(i + 1)->getID()));
 	}
 
-	// calculate the shortest tree rooted at target vertex in the graph
-	Dijkstra reverse_tree(mpGraph);
-	reverse_tree.getShortestPathFlower(mpTargetVertex);
+	// a spur path is of use up to the cost of the k-th candidate less the cost of the root path to the deviation vertex,
+	// with some slack for the rounding of the sums
+	double max_distance = Graph::DISCONNECT;
+	if (max_cost < Graph::DISCONNECT)
+	{
+		double root_cost = 0;
+		for (int i = 0; i < sub_path_length; ++i)
+		{
+			root_cost += mpGraph->getOriginalEdgeWeight(cur_path->getVertex(i), cur_path->getVertex(i + 1));
+		}
+		max_distance = max_cost - root_cost + 1e-9 * max_cost;
+	}
+
+	// the shortest tree rooted at target vertex in the graph, repaired or built anew
+	Dijkstra fresh_tree(mpGraph);
+	Dijkstra &reverse_tree = mIsTreeReused ? *mpReverseTree : fresh_tree;
+	if (mIsTreeReused)
+	{
+		repairReverseTree(cur_path, max_distance);
+	}
+	else
+	{
+		buildReverseTree(fresh_tree);
+	}
 
 	// recover the deleted vertices and update the cost and identify the new candidates results
 	bool is_done = false;
@@ -111,16 +266,17 @@ BasePath *Yen::next()
 		}
 
 		// calculate cost using forward star form
-		BasePath *sub_path = reverse_tree.updateCostForward(cur_recover_vertex);
+		BasePath *sub_path = reverse_tree.updateCostForward(cur_recover_vertex, max_distance);
 
 		// get one candidate result if possible
 		if (sub_path != NULL)
 		{
 			++mGeneratedPathNum;
+			INSTRUMENT_COUNT(SPUR_CANDIDATES);
 
 			// get the prefix from the concerned path
 			double cost = 0;
-			reverse_tree.correctCostBackward(cur_recover_vertex);
+			reverse_tree.correctCostBackward(cur_recover_vertex, max_distance);
 			std::vector<BaseVertex *> pre_path_list;
 			for (int j = 0; j < path_length; ++j)
 			{
@@ -142,13 +298,18 @@ BasePath *Yen::next()
 			}
 
 			// compose a candidate
-			sub_path = new Path(pre_path_list, cost + sub_path->Weight());
+			BasePath *candidate = new Path(pre_path_list, cost + sub_path->Weight());
+			delete sub_path;
 
-			// put it in the candidate pool if new
-			if (mmDerivationVertexIndex.find(sub_path) == mmDerivationVertexIndex.end())
+			// put it in the candidate pool if new and not beyond the k-th candidate
+			if (candidate->Weight() <= max_cost && mmDerivationVertexIndex.find(candidate) == mmDerivationVertexIndex.end())
 			{
-				mqPathCandidates.insert(sub_path);
-				mmDerivationVertexIndex[sub_path] = cur_recover_vertex;
+				mqPathCandidates.insert(candidate);
+				mmDerivationVertexIndex[candidate] = cur_recover_vertex;
+			}
+			else
+			{
+				delete candidate;
 			}
 		}
 
@@ -158,15 +319,19 @@ BasePath *Yen::next()
 
 		// update cost if necessary
 		double cost_1 = mpGraph->getEdgeWeight(cur_recover_vertex, succ_vertex) + reverse_tree.getStartDistanceAt(succ_vertex);
-		if (reverse_tree.getStartDistanceAt(cur_recover_vertex) > cost_1)
+		if (reverse_tree.getStartDistanceAt(cur_recover_vertex) > cost_1 && cost_1 <= max_distance)
 		{
 			reverse_tree.setStartDistanceAt(cur_recover_vertex, cost_1);
 			reverse_tree.setPredecessorVertex(cur_recover_vertex, succ_vertex);
-			reverse_tree.correctCostBackward(cur_recover_vertex);
+			reverse_tree.correctCostBackward(cur_recover_vertex, max_distance);
 		}
 	}
 
 	// restore everything
+	if (mIsTreeReused)
+	{
+		mpReverseTree->rollBack();
+	}
 	mpGraph->recoverRemovedEdges();
 	mpGraph->recoverRemovedVertices();
 	return cur_path;
@@ -177,6 +342,7 @@ void Yen::getShortestPaths(BaseVertex *pSource, BaseVertex *pTarget, int top_k,
 	mpSourceVertex = pSource;
 	mpTargetVertex = pTarget;
 	initialize();
+	mRemainingPathNum = top_k;
 	int count = 0;
 	while (hasNext() && count < top_k)
 	{
@@ -1,26 +1,49 @@
 #ifndef __YEN_H__
 #define __YEN_H__
 
-/* Yen's algorithm to get the top k shortest paths connecting a pair of vertices in a graph. */
+class Dijkstra;
+class DeltaStepping;
+
+/* Yen's algorithm to get the top k shortest paths connecting a pair of vertices in a graph.
+The reverse shortest path tree of the target is built once per query. At every iteration, only the vertices whose tree
+path crosses the removed root path are searched again, and the changes are rolled back afterwards; knowing k, that search
+stops at the cost of the k-th candidate.
+It works on its own copy of the graph, so that several queries can share one graph from parallel threads.
+The returned paths belong to the object and live until clear() or its destruction. */
 class Yen
 {
 public:
-	Yen(const Graph &graph)
+	Yen(const Graph &graph) : Yen(graph, NULL, NULL) {}
+	Yen(const Graph &graph, BaseVertex* pSource, BaseVertex* pTarget)
+		: mpSourceVertex(pSource), mpTargetVertex(pTarget), mThreadNum(1), mpTreeBuilder(NULL), mIsKernelSearch(false), mIsTreeReused(true), mpReverseTree(NULL)
 	{
-		Yen(graph, NULL, NULL);
+		mpGraph = new Graph(graph);
+		initialize();
 	}
-	Yen(const Graph &graph, BaseVertex* pSource, BaseVertex* pTarget) : mpSourceVertex(pSource), mpTargetVertex(pTarget)
+	/* The first path is given rather than searched, e.g. by PartitionOverlay, with the weights of the graph; it is copied */
+	Yen(const Graph &graph, BasePath* pShortestPath)
+		: mpSourceVertex(NULL), mpTargetVertex(NULL), mThreadNum(1), mpTreeBuilder(NULL), mIsKernelSearch(false), mIsTreeReused(true), mpReverseTree(NULL)
 	{
 		mpGraph = new Graph(graph);
-		initialize();
+		initialize(pShortestPath);
 	}
-	~Yen(void) { clear(); }
+	~Yen(void);
 
 	bool 		hasNext();
 	BasePath*	next();
 	BasePath*	getShortestPath(BaseVertex* pSource, BaseVertex* pTarget);
+	/* Knowing k, the candidates costing more than the k-th one are dropped: the object is done with the query afterwards */
 	void 		getShortestPaths(BaseVertex* pSource, BaseVertex* pTarget, int top_k, std::vector<BasePath*>&);
 	void 		clear();
+	/* With more than one thread, the reverse shortest path trees are built by parallel delta-stepping */
+	void 		setThreadNum(int thread_num) 		{ mThreadNum = thread_num; }
+	/* The reverse shortest path trees are built by the SearchKernel instantiation of the graph rather than by Dijkstra */
+	void 		setKernelSearch(bool is_kernel) 	{ mIsKernelSearch = is_kernel; }
+	/* Without reuse, the tree is built again on the whole graph at every iteration, as a reference */
+	void 		setTreeReuse(bool is_reused) 		{ mIsTreeReused = is_reused; }
+	/* Spur paths found, and vertices of the tree searched again, since the query started */
+	int 		getGeneratedPathNum() const 		{ return mGeneratedPathNum; }
+	long long 	getRepairedVertexNum() const 		{ return mRepairedVertexNum; }
 
 private:
 	Graph*											mpGraph;
@@ -30,8 +53,22 @@ private:
 	BaseVertex*										mpSourceVertex;
 	BaseVertex*										mpTargetVertex;
 	int 											mGeneratedPathNum;
+	int 											mThreadNum;
+	DeltaStepping*									mpTreeBuilder;
+	bool 											mIsKernelSearch;
+	int 											mRemainingPathNum;
+	long long 										mRepairedVertexNum;
+
+	// reverse shortest path tree of the target on the whole graph, with the children of every vertex by index
+	bool 											mIsTreeReused;
+	Dijkstra*										mpReverseTree;
+	std::vector<std::vector<BaseVertex*>> 			mvTreeChildren;
+	std::vector<int> 								mvTreeStamp;
+	int 											mTreeStamp;
 
-	void initialize();
+	void initialize(BasePath* pShortestPath = NULL);
+	void buildReverseTree(Dijkstra &reverse_tree);
+	void repairReverseTree(BasePath* cur_path, double max_distance);
 };
 
 #endif // __YEN_H__
@@ -0,0 +1,297 @@
+#include "main.h"
+#include <deque>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <sys/stat.h>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "GraphImage.h"
+#include "BatchRunner.h"
+
+/* Batch of requests over worker processes sharing a mapped image of the graph.
+The image is written on the first run, when the graph file is newer, or when it was written with another weight unit
+or vertex order; by default it is kept in the temporary directory, out of the tree of the graph file. */
+struct BatchOptions
+{
+	std::string 		graph_file;
+	std::string 		image_file;
+	std::string 		request_file;
+	std::string 		out_file;
+	std::vector<int> 	process_nums;
+	int 				chunk_size;
+	double 				timeout_s;
+	int 				max_attempts;
+	int 				max_k;
+	int 				max_flow_limit;
+	int 				random_num;
+	int 				top_k;
+	unsigned int 		seed;
+	double 				weight_unit;
+	Graph::VertexOrder 	vertex_order;
+	std::string 		label;
+};
+
+void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " <graph_file> [options]\n"
+			  << "  --image <file>        graph image, written from the graph file if missing, older or of other options (default in $TMPDIR or /tmp)\n"
+			  << "  --requests <file>     request lines as for the query server, '<source> <target> <k>' for KSP (default stdin)\n"
+			  << "  --random <n>          n random KSP requests instead\n"
+			  << "  --k <n>               k of the random requests\n"
+			  << "  --seed <n>            seed of the random requests\n"
+			  << "  --out <file>          answers, one JSON line per request in order (default stdout)\n"
+			  << "  --processes <n1,n2>   worker processes, one run per value, the answers of the last one are written\n"
+			  << "  --chunk <n>           requests in flight per worker\n"
+			  << "  --timeout <s>         a worker longer on one request is restarted, 0 for no limit\n"
+			  << "  --attempts <n>        failed attempts before a request is answered with an error\n"
+			  << "  --max-k <n>           largest k of a KSP request\n"
+			  << "  --maxflow-limit <n>   largest graph answering MAXFLOW requests\n"
+			  << "  --weight-unit <km>    integer weight mode of a new image\n"
+			  << "  --vertex-order <o>    bfs or rcm storage order of a new image\n"
+			  << "  --label <text>        tag of the records\n";
+}
+
+static bool isOlder(const std::string &file_name, const std::string &than_file_name)
+{
+	struct stat file_stat, than_stat;
+	if (stat(file_name.c_str(), &file_stat) != 0)
+	{
+		return true;
+	}
+	return stat(than_file_name.c_str(), &than_stat) == 0 && file_stat.st_mtime < than_stat.st_mtime;
+}
+
+/* The image of a graph file in $TMPDIR (/tmp otherwise), named after the whole path of the file,
+so that graph files of the same name in other directories do not share it */
+std::string defaultImageFile(const std::string &graph_file)
+{
+	char *real_path = realpath(graph_file.c_str(), NULL);
+	std::string name = real_path != NULL ? real_path : graph_file;
+	free(real_path);
+	std::replace(name.begin(), name.end(), '/', '_');
+	const char *temp_dir = getenv("TMPDIR");
+	return std::string(temp_dir != NULL && *temp_dir != '\0' ? temp_dir : "/tmp") + "/" + name + ".img";
+}
+
+/* Request lines without the blank ones; bare '<source> <target> <k>' lines are KSP requests */
+void readRequests(std::istream &in, std::vector<std::string> &requests)
+{
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+		{
+			line.erase(line.size() - 1);
+		}
+		size_t start_pos = line.find_first_not_of(" \t");
+		if (start_pos == std::string::npos)
+		{
+			continue;
+		}
+		requests.push_back(isdigit(line[start_pos]) ? "KSP " + line.substr(start_pos) : line.substr(start_pos));
+	}
+}
+
+void randomRequests(const GraphImage &image, const BatchOptions &options, std::vector<std::string> &requests)
+{
+	if (image.getVertexNum() < 2)
+	{
+		std::cerr << "The graph has too few vertices." << std::endl;
+		exit(1);
+	}
+	std::mt19937 rng(options.seed);
+	std::uniform_int_distribution<int> pick(0, image.getVertexNum() - 1);
+	for (int i = 0; i < options.random_num; ++i)
+	{
+		int source = pick(rng);
+		int target = pick(rng);
+		while (target == source)
+		{
+			target = pick(rng);
+		}
+		requests.push_back("KSP " + std::to_string(image.getVertexIds()[source]) + " " + std::to_string(image.getVertexIds()[target]) + " " + std::to_string(options.top_k));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+	BatchOptions options;
+	options.graph_file = argv[1];
+	options.image_file = defaultImageFile(options.graph_file);
+	options.chunk_size = 8;
+	options.timeout_s = 0;
+	options.max_attempts = 3;
+	options.max_k = 1000;
+	options.max_flow_limit = 1000;
+	options.random_num = 0;
+	options.top_k = 10;
+	options.seed = 1;
+	options.weight_unit = 0;
+	options.vertex_order = Graph::ORDER_FIRST_SEEN;
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "--image")
+		{
+			options.image_file = value;
+		}
+		else if (option == "--requests")
+		{
+			options.request_file = value;
+		}
+		else if (option == "--random")
+		{
+			options.random_num = atoi(value.c_str());
+		}
+		else if (option == "--k")
+		{
+			options.top_k = atoi(value.c_str());
+		}
+		else if (option == "--seed")
+		{
+			options.seed = atoi(value.c_str());
+		}
+		else if (option == "--out")
+		{
+			options.out_file = value;
+		}
+		else if (option == "--processes")
+		{
+			std::stringstream ss(value);
+			std::string item;
+			while (std::getline(ss, item, ','))
+			{
+				options.process_nums.push_back(std::max(1, atoi(item.c_str())));
+			}
+		}
+		else if (option == "--chunk")
+		{
+			options.chunk_size = atoi(value.c_str());
+		}
+		else if (option == "--timeout")
+		{
+			options.timeout_s = atof(value.c_str());
+		}
+		else if (option == "--attempts")
+		{
+			options.max_attempts = atoi(value.c_str());
+		}
+		else if (option == "--max-k")
+		{
+			options.max_k = atoi(value.c_str());
+		}
+		else if (option == "--maxflow-limit")
+		{
+			options.max_flow_limit = atoi(value.c_str());
+		}
+		else if (option == "--weight-unit")
+		{
+			options.weight_unit = atof(value.c_str());
+		}
+		else if (option == "--vertex-order" && (value == "bfs" || value == "rcm"))
+		{
+			options.vertex_order = value == "bfs" ? Graph::ORDER_BFS : Graph::ORDER_RCM;
+		}
+		else if (option == "--label")
+		{
+			options.label = value;
+		}
+		else
+		{
+			argc = 0;
+		}
+	}
+	if (argc < 2 || argc % 2 != 0)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+	if (options.process_nums.empty())
+	{
+		options.process_nums.push_back(1);
+	}
+
+	// written aside then renamed, so that a process never maps a half-written image
+	GraphImage::Header header;
+	bool is_outdated = isOlder(options.image_file, options.graph_file) || !GraphImage::readHeader(options.image_file, header);
+	if (!is_outdated && (header.weight_unit != options.weight_unit || header.vertex_order != options.vertex_order))
+	{
+		std::cerr << "The image " << options.image_file << " was written with another weight unit or vertex order, it is written again." << std::endl;
+		is_outdated = true;
+	}
+	if (is_outdated)
+	{
+		Graph graph(options.graph_file, options.weight_unit, options.vertex_order, true);
+		graph.saveImage(options.image_file + ".tmp");
+		if (rename((options.image_file + ".tmp").c_str(), options.image_file.c_str()) != 0)
+		{
+			std::cerr << "The image " << options.image_file << " can not be written." << std::endl;
+			return 1;
+		}
+	}
+	GraphImage image(options.image_file);
+
+	std::vector<std::string> requests;
+	if (options.random_num > 0)
+	{
+		randomRequests(image, options, requests);
+	}
+	else if (options.request_file.empty())
+	{
+		readRequests(std::cin, requests);
+	}
+	else
+	{
+		std::ifstream ifs(options.request_file.c_str());
+		if (!ifs)
+		{
+			std::cerr << "The file " << options.request_file << " can not be opened!" << std::endl;
+			return 1;
+		}
+		readRequests(ifs, requests);
+	}
+
+	std::ofstream out_file;
+	if (!options.out_file.empty())
+	{
+		out_file.open(options.out_file.c_str());
+		if (!out_file)
+		{
+			std::cerr << "The file " << options.out_file << " can not be opened!" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &answer_out = options.out_file.empty() ? std::cout : out_file;
+	std::ostringstream discarded;
+
+	// one record per process count, on the error stream as the answers may be on the standard output
+	double first_throughput = 0;
+	int error_num = 0;
+	for (size_t i = 0; i < options.process_nums.size(); ++i)
+	{
+		bool is_last = i + 1 == options.process_nums.size();
+		BatchRunner runner(image, options.process_nums[i], options.chunk_size, options.timeout_s, options.max_attempts, options.max_k, options.max_flow_limit);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		runner.run(requests, is_last ? answer_out : discarded);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		discarded.str(std::string());
+
+		double throughput = seconds > 0 ? requests.size() / seconds : 0;
+		first_throughput = i == 0 ? throughput : first_throughput;
+		std::cerr << "{\"case\":\"batch\",\"label\":\"" << options.label << "\",\"vertices\":" << image.getVertexNum() << ",\"edges\":" << image.getEdgeNum()
+				  << ",\"processes\":" << options.process_nums[i] << ",\"chunk\":" << options.chunk_size << ",\"requests\":" << requests.size()
+				  << ",\"seconds\":" << seconds << ",\"throughput\":" << throughput << ",\"speedup\":" << (first_throughput > 0 ? throughput / first_throughput : 0)
+				  << ",\"restarts\":" << runner.getRestartNum() << ",\"failed\":" << runner.getFailedRequestNum() << ",\"errors\":" << runner.getErrorAnswerNum()
+				  << ",\"image_bytes\":" << image.getByteNum() << ",\"worker_private_kb\":" << runner.getWorkerPrivateKb()
+				  << ",\"worker_mapped_kb\":" << runner.getWorkerMappedKb() << ",\"digest\":\"" << std::hex << runner.getAnswerDigest() << std::dec << "\"}" << std::endl;
+		error_num = runner.getFailedRequestNum();
+	}
+	return error_num > 0 ? 1 : 0;
+}
@@ -0,0 +1,1224 @@
+#include "main.h"
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "Dijkstra.h"
+#include "Yen.h"
+#include "MaxFlow.h"
+#include "FlatGraph.h"
+#include "PathConstraints.h"
+#include "ConstrainedYen.h"
+#include "Feng.h"
+#include "Eppstein.h"
+#include "ManyToMany.h"
+#include "DeltaStepping.h"
+#include "MonotoneQueue.h"
+#include "SearchKernel.h"
+#include "PartitionOverlay.h"
+#include "GraphGenerator.h"
+#include "Instrument.h"
+
+/* One benchmark measurement, printed as a single line of JSON. */
+class BenchRecord
+{
+public:
+	BenchRecord(const std::string &bench_case) : mBody("{\"case\":\"" + bench_case + "\"") {}
+
+	BenchRecord& 	add(const std::string &key, const std::string &value) 	{ mBody += ",\"" + key + "\":\"" + value + "\""; return *this; }
+	BenchRecord& 	add(const std::string &key, double value)
+	{
+		// counts stay whole numbers instead of turning to the scientific notation
+		std::ostringstream oss;
+		if (value == std::floor(value) && std::abs(value) < 1e15)
+		{
+			oss << (long long)value;
+		}
+		else
+		{
+			oss << value;
+		}
+		mBody += ",\"" + key + "\":" + oss.str();
+		return *this;
+	}
+	std::string 	str() const 											{ return mBody + "}"; }
+
+private:
+	std::string 	mBody;
+};
+
+/* Hardware cache misses of the calling thread, -1 where the performance counters are not available. */
+class CacheMissCounter
+{
+public:
+	CacheMissCounter(void) : mFd(-1)
+	{
+#ifdef __linux__
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		mFd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter(void)
+	{
+#ifdef __linux__
+		if (mFd >= 0)
+		{
+			close(mFd);
+		}
+#endif
+	}
+
+	void 		start()
+	{
+#ifdef __linux__
+		if (mFd >= 0)
+		{
+			ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	long long 	stop()
+	{
+		long long miss_num = -1;
+#ifdef __linux__
+		if (mFd >= 0)
+		{
+			ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(mFd, &miss_num, sizeof(miss_num)) != sizeof(miss_num))
+			{
+				miss_num = -1;
+			}
+		}
+#endif
+		return miss_num;
+	}
+
+private:
+	int 	mFd;
+};
+
+struct BenchOptions
+{
+	std::string 				graph_file;
+	std::vector<std::string> 	kinds;
+	std::vector<long long> 		edge_nums;
+	std::vector<int> 			top_ks;
+	std::vector<int> 			feng_ks;
+	int 						yen_limit;
+	std::vector<int> 			eppstein_ks;
+	std::vector<int> 			overlay_cells;
+	int 						query_num;
+	int 						thread_num;
+	int 						max_flow_limit;
+	int 						filter_limit;
+	double 						weight_unit;
+	unsigned int 				seed;
+	std::string 				work_dir;
+	std::string 				label;
+	std::string 				out_file;
+	std::string 				profile_file;
+	std::string 				trace_file;
+};
+
+double elapsedMs(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::string> splitList(const std::string &text)
+{
+	std::vector<std::string> items;
+	std::istringstream iss(text);
+	std::string item;
+	while (std::getline(iss, item, ','))
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+/* Every record starts with the release label and the description of the graph. */
+BenchRecord graphRecord(const std::string &label, const std::string &graph_name, const Graph &graph, const std::string &bench_case)
+{
+	return BenchRecord(bench_case).add("label", label).add("graph", graph_name).add("vertices", graph.getVertexNum()).add("edges", graph.getEdgeNum());
+}
+
+/* Distance matrix between random vertices: lockstep batches vs. one reverse shortest path tree per target. */
+void benchManyToMany(Graph &graph, const std::vector<BaseVertex *> &vertices, int thread_num, BenchRecord &record)
+{
+	int n = vertices.size();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<double> flower_matrix((size_t)n * n, Graph::DISCONNECT);
+	for (int t = 0; t < n; ++t)
+	{
+		Dijkstra reverse_tree(&graph);
+		reverse_tree.getShortestPathFlower(vertices[t]);
+		for (int s = 0; s < n; ++s)
+		{
+			flower_matrix[(size_t)s * n + t] = vertices[s] == vertices[t] ? 0 : reverse_tree.getStartDistanceAt(vertices[s]);
+		}
+	}
+	double flower_ms = elapsedMs(start);
+
+	start = std::chrono::steady_clock::now();
+	ManyToMany many2many(&graph);
+	std::vector<double> matrix;
+	many2many.getDistanceMatrix(vertices, vertices, matrix, thread_num);
+	double batched_ms = elapsedMs(start);
+
+	int mismatch_num = 0;
+	for (size_t i = 0; i < matrix.size(); ++i)
+	{
+		if (std::abs(matrix[i] - flower_matrix[i]) > 1e-9 * (1 + std::abs(flower_matrix[i])))
+		{
+			++mismatch_num;
+		}
+	}
+	record.add("sources", n).add("targets", n).add("threads", thread_num)
+		.add("flower_ms", flower_ms).add("ms", batched_ms).add("mismatches", mismatch_num);
+}
+
+/* Max flow between two vertices, the capacity of an edge being its length in units of 10 m. */
+void benchMaxFlow(Graph &graph, BaseVertex *source, BaseVertex *sink, BenchRecord &record)
+{
+	std::vector<std::vector<int>> capacity;
+	PushRelabel_capacities(graph, capacity);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int max_flow = PushRelabel_FIFO(capacity, source->getIndex(), sink->getIndex());
+	record.add("ms", elapsedMs(start)).add("flow", max_flow);
+}
+
+/* Shortest paths in the integer weight mode vs. double weights.
+Rounding every edge by at most half a unit, the two distances differ by at most half a unit per edge of the longer path. */
+void benchIntegerWeights(Graph &graph, const std::string &file_name, const std::vector<std::pair<BaseVertex *, BaseVertex *>> &queries,
+						 double weight_unit, BenchRecord &record)
+{
+	Graph int_graph(file_name, weight_unit);
+	double double_ms = 0, int_ms = 0, max_error = 0;
+	int violation_num = 0;
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Dijkstra dijkstra_alg(&graph);
+		BasePath *path = dijkstra_alg.getShortestPath(queries[i].first, queries[i].second);
+		double_ms += elapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		Dijkstra int_dijkstra_alg(&int_graph);
+		BasePath *int_path = int_dijkstra_alg.getShortestPath(int_graph.getVertex(queries[i].first->getID()), int_graph.getVertex(queries[i].second->getID()));
+		int_ms += elapsedMs(start);
+
+		if (path->Weight() < Graph::DISCONNECT && int_path->Weight() < Graph::DISCONNECT)
+		{
+			double error = std::abs(path->Weight() - int_path->Weight());
+			double bound = std::max(path->length(), int_path->length()) * weight_unit / 2 + 1e-9;
+			max_error = std::max(max_error, error);
+			violation_num += error > bound ? 1 : 0;
+		}
+		else if (path->Weight() < Graph::DISCONNECT || int_path->Weight() < Graph::DISCONNECT)
+		{
+			++violation_num;
+		}
+		delete path;
+		delete int_path;
+	}
+	record.add("weight_unit", weight_unit).add("queue", int_graph.getMaxIntEdgeWeight() <= Dijkstra::MAX_BUCKET_WEIGHT ? "dial" : "radix")
+		.add("queries", queries.size()).add("double_ms", double_ms / queries.size()).add("ms", int_ms / queries.size())
+		.add("max_error", max_error).add("violations", violation_num);
+}
+
+/* Full reverse shortest path tree: Dijkstra vs. delta-stepping on 1, 2, 4... threads. */
+void benchDeltaStepping(Graph &graph, BaseVertex *root, const BenchOptions &options, const std::string &graph_name, std::ostream &out)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Dijkstra reverse_tree(&graph);
+	reverse_tree.getShortestPathFlower(root);
+	double dijkstra_ms = elapsedMs(start);
+
+	const std::vector<BaseVertex *> &vertices = graph.getVertexList();
+	for (int thread_num = 1;; thread_num = std::min(thread_num * 2, options.thread_num))
+	{
+		start = std::chrono::steady_clock::now();
+		DeltaStepping delta_stepping(&graph, thread_num);
+		double setup_ms = elapsedMs(start);
+		start = std::chrono::steady_clock::now();
+		delta_stepping.getShortestPathFlower(root);
+		double search_ms = elapsedMs(start);
+
+		int mismatch_num = 0;
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			double expected = vertices[i] == root ? 0 : reverse_tree.getStartDistanceAt(vertices[i]);
+			double distance = delta_stepping.getStartDistanceAt(vertices[i]);
+			if (std::abs(distance - expected) > 1e-9 * (1 + std::abs(expected)))
+			{
+				++mismatch_num;
+			}
+		}
+		out << graphRecord(options.label, graph_name, graph, "delta_stepping").add("threads", thread_num).add("delta", delta_stepping.getDelta())
+				.add("dijkstra_ms", dijkstra_ms).add("setup_ms", setup_ms).add("ms", search_ms).add("mismatches", mismatch_num).str() << std::endl;
+		if (thread_num >= options.thread_num)
+		{
+			break;
+		}
+	}
+}
+
+/* Searches on the flat snapshot for every storage order of the vertices. The locality is the mean gap
+between the indices of the two ends of an edge; cache misses are counted over the searches. */
+void benchVertexOrder(const std::string &graph_name, const std::string &file_name, const std::vector<std::pair<int, int>> &query_ids,
+					  const BenchOptions &options, std::ostream &out)
+{
+	const char *order_names[] = {"first_seen", "bfs", "rcm"};
+	for (int order = Graph::ORDER_FIRST_SEEN; order <= Graph::ORDER_RCM; ++order)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Graph graph(file_name, 0, (Graph::VertexOrder)order);
+		double load_ms = elapsedMs(start);
+		FlatGraph flat_graph(graph);
+		double index_gap = 0;
+		for (int v = 0; v < flat_graph.getVertexNum(); ++v)
+		{
+			for (int e = flat_graph.outBegin(v); e < flat_graph.outEnd(v); ++e)
+			{
+				index_gap += std::abs(flat_graph.outTarget(e) - v);
+			}
+		}
+
+		std::vector<BaseVertex *> sources, targets;
+		for (size_t i = 0; i < query_ids.size(); ++i)
+		{
+			sources.push_back(graph.getVertex(query_ids[i].first));
+			targets.push_back(graph.getVertex(query_ids[i].second));
+		}
+		CacheMissCounter cache_misses;
+		ManyToMany many2many(&graph);
+		DeltaStepping delta_stepping(&graph, 1);
+		std::vector<double> matrix;
+		cache_misses.start();
+		start = std::chrono::steady_clock::now();
+		many2many.getDistanceMatrix(sources, targets, matrix, 1);
+		double many2many_ms = elapsedMs(start);
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < targets.size(); ++i)
+		{
+			delta_stepping.getShortestPathFlower(targets[i]);
+		}
+		double tree_ms = elapsedMs(start) / targets.size();
+		long long miss_num = cache_misses.stop();
+
+		out << graphRecord(options.label, graph_name, graph, "vertex_order").add("order", order_names[order]).add("load_ms", load_ms)
+				.add("mean_index_gap", flat_graph.getEdgeNum() > 0 ? index_gap / flat_graph.getEdgeNum() : 0)
+				.add("many2many_ms", many2many_ms).add("tree_ms", tree_ms).add("cache_misses", miss_num).str() << std::endl;
+	}
+}
+
+/* Memory footprint of the maps vs. the compact storage, with the same shortest path queries on both.
+The float weights of the compact mode round every edge by a relative 2^-24 at most. */
+void benchStorage(const std::string &graph_name, const std::string &file_name, const std::vector<std::pair<int, int>> &query_ids,
+				  const BenchOptions &options, std::ostream &out)
+{
+	std::vector<double> distances(query_ids.size());
+	for (int is_compact = 0; is_compact <= 1; ++is_compact)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Graph graph(file_name, 0, Graph::ORDER_FIRST_SEEN, is_compact);
+		double load_ms = elapsedMs(start);
+
+		double max_error = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < query_ids.size(); ++i)
+		{
+			Dijkstra dijkstra_alg(&graph);
+			BasePath *path = dijkstra_alg.getShortestPath(graph.getVertex(query_ids[i].first), graph.getVertex(query_ids[i].second));
+			if (is_compact && path->Weight() < Graph::DISCONNECT)
+			{
+				max_error = std::max(max_error, std::abs(path->Weight() - distances[i]) / std::max(distances[i], 1e-9));
+			}
+			distances[i] = path->Weight();
+			delete path;
+		}
+		double dijkstra_ms = elapsedMs(start) / query_ids.size();
+
+		std::vector<std::pair<std::string, size_t>> footprint;
+		graph.getMemoryFootprint(footprint);
+		BenchRecord record = graphRecord(options.label, graph_name, graph, "storage");
+		record.add("mode", is_compact ? "compact" : "maps").add("load_ms", load_ms);
+		size_t total = 0;
+		for (size_t i = 0; i < footprint.size(); ++i)
+		{
+			record.add(footprint[i].first + "_mib", footprint[i].second / 1048576.0);
+			total += footprint[i].second;
+		}
+		record.add("mib", total / 1048576.0).add("bytes_per_edge", graph.getEdgeNum() > 0 ? (double)total / graph.getEdgeNum() : 0)
+			.add("dijkstra_ms", dijkstra_ms).add("max_relative_error", max_error);
+		out << record.str() << std::endl;
+	}
+}
+
+/* One instantiation of the search kernel and its run-time branching baseline, their times and counts summed over the queries */
+struct KernelBench
+{
+	SearchKernelBase* 	kernel;
+	SearchKernelBase* 	runtime_kernel;
+	double 				setup_ms;
+	double 				ms;
+	double 				runtime_ms;
+	long long 			settled_num;
+	int 				mismatch_num;
+	int 				runtime_mismatch_num;
+};
+
+template <SearchDirection Direction, class Weight, class Queue>
+void addKernelBench(Graph &graph, double weight_unit, std::vector<KernelBench> &benches)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SearchKernelBase *kernel = new SearchKernel<Direction, Weight, Queue>(graph, weight_unit);
+	double setup_ms = elapsedMs(start);
+	RuntimeSearchKernel::WeightType weight_type = std::is_integral<Weight>::value ? RuntimeSearchKernel::WEIGHT_INT
+		: (std::is_same<Weight, float>::value ? RuntimeSearchKernel::WEIGHT_FLOAT : RuntimeSearchKernel::WEIGHT_DOUBLE);
+	RuntimeSearchKernel::QueueType queue_type = std::is_same<Queue, BucketQueue<int>>::value ? RuntimeSearchKernel::QUEUE_BUCKET
+		: (std::is_same<Queue, RadixHeap<int>>::value ? RuntimeSearchKernel::QUEUE_RADIX : RuntimeSearchKernel::QUEUE_HEAP);
+	SearchKernelBase *runtime_kernel = new RuntimeSearchKernel(graph, Direction, weight_type, queue_type, weight_unit);
+	KernelBench bench = {kernel, runtime_kernel, setup_ms, 0, 0, 0, 0, 0};
+	benches.push_back(bench);
+}
+
+/* Searches compiled per direction, weight type and queue vs. Dijkstra, which branches on them at every edge, and vs. the
+same loop on the same packed edges branching on them at run time (RuntimeSearchKernel), which isolates the specialization.
+Each weight mode has its own kernels, checked against Dijkstra on the same graph: the double weights of the maps,
+the float weights of the compact mode, and the integer weights. The forward searches stop at the target as
+getShortestPath does, the backward ones build the whole reverse tree of the target as getShortestPathFlower.
+The picked kernel is the one createSearchKernel, and thus the command line, uses in that mode. */
+void benchSearchKernel(const std::string &graph_name, const std::string &file_name, const std::vector<std::pair<int, int>> &query_ids,
+					   const BenchOptions &options, std::ostream &out)
+{
+	const char *mode_names[] = {"maps", "compact", "integer"};
+	for (int mode = 0; mode < 3; ++mode)
+	{
+		double weight_unit = mode == 2 ? options.weight_unit : 0;
+		Graph graph(file_name, weight_unit, Graph::ORDER_FIRST_SEEN, mode == 1);
+		std::vector<KernelBench> benches;
+		if (mode == 0)
+		{
+			addKernelBench<SEARCH_FORWARD, double, BinaryHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, double, BinaryHeap<int>>(graph, weight_unit, benches);
+		}
+		else if (mode == 1)
+		{
+			addKernelBench<SEARCH_FORWARD, float, BinaryHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, float, BinaryHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_FORWARD, double, BinaryHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, double, BinaryHeap<int>>(graph, weight_unit, benches);
+		}
+		else
+		{
+			addKernelBench<SEARCH_FORWARD, unsigned int, BucketQueue<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, unsigned int, BucketQueue<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_FORWARD, unsigned int, RadixHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, unsigned int, RadixHeap<int>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_FORWARD, unsigned int, BinaryHeap<int, unsigned long long>>(graph, weight_unit, benches);
+			addKernelBench<SEARCH_BACKWARD, unsigned int, BinaryHeap<int, unsigned long long>>(graph, weight_unit, benches);
+		}
+		SearchKernelBase *picked_kernel = createSearchKernel(graph, SEARCH_FORWARD);
+		std::string picked_name = picked_kernel->getName().substr(picked_kernel->getName().find('/') + 1);
+		delete picked_kernel;
+
+		const std::vector<BaseVertex *> &vertices = graph.getVertexList();
+		double dijkstra_ms = 0, flower_ms = 0;
+		for (size_t i = 0; i < query_ids.size(); ++i)
+		{
+			BaseVertex *source = graph.getVertex(query_ids[i].first);
+			BaseVertex *target = graph.getVertex(query_ids[i].second);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Dijkstra dijkstra_alg(&graph);
+			BasePath *path = dijkstra_alg.getShortestPath(source, target);
+			dijkstra_ms += elapsedMs(start);
+			start = std::chrono::steady_clock::now();
+			Dijkstra reverse_tree(&graph);
+			reverse_tree.getShortestPathFlower(target);
+			flower_ms += elapsedMs(start);
+
+			// the distance to the target forward, the whole reverse tree backward
+			auto isEqual = [&](SearchKernelBase *kernel) {
+				bool is_forward = kernel->getDirection() == SEARCH_FORWARD;
+				bool is_equal = !is_forward || std::abs(kernel->getDistance(target->getIndex()) - path->Weight()) <= 1e-9 * (1 + path->Weight());
+				for (size_t v = 0; !is_forward && is_equal && v < vertices.size(); ++v)
+				{
+					double expected = vertices[v] == target ? 0 : reverse_tree.getStartDistanceAt(vertices[v]);
+					is_equal = std::abs(kernel->getDistance(v) - expected) <= 1e-9 * (1 + std::abs(expected));
+				}
+				return is_equal;
+			};
+			for (size_t j = 0; j < benches.size(); ++j)
+			{
+				bool is_forward = benches[j].kernel->getDirection() == SEARCH_FORWARD;
+				// the one running second finds the query in the caches: the order alternates between the queries
+				for (int turn = 0; turn < 2; ++turn)
+				{
+					int round = (turn + i) % 2;
+					SearchKernelBase *kernel = round == 0 ? benches[j].kernel : benches[j].runtime_kernel;
+					start = std::chrono::steady_clock::now();
+					if (is_forward)
+					{
+						kernel->search(source->getIndex(), target->getIndex());
+					}
+					else
+					{
+						kernel->search(target->getIndex());
+					}
+					(round == 0 ? benches[j].ms : benches[j].runtime_ms) += elapsedMs(start);
+					benches[j].settled_num += round == 0 ? kernel->getSettledNum() : 0;
+					(round == 0 ? benches[j].mismatch_num : benches[j].runtime_mismatch_num) += isEqual(kernel) ? 0 : 1;
+				}
+			}
+			delete path;
+		}
+
+		for (size_t j = 0; j < benches.size(); ++j)
+		{
+			bool is_forward = benches[j].kernel->getDirection() == SEARCH_FORWARD;
+			std::string name = benches[j].kernel->getName();
+			double runtime_ms = (is_forward ? dijkstra_ms : flower_ms) / query_ids.size();
+			double ms = benches[j].ms / query_ids.size();
+			double branching_ms = benches[j].runtime_ms / query_ids.size();
+			out << graphRecord(options.label, graph_name, graph, "search_kernel").add("mode", mode_names[mode]).add("kernel", name)
+					.add("picked", name.substr(name.find('/') + 1) == picked_name ? "yes" : "no").add("queries", query_ids.size())
+					.add("setup_ms", benches[j].setup_ms).add("ms", ms).add("dijkstra_ms", runtime_ms).add("speedup", ms > 0 ? runtime_ms / ms : 0)
+					.add("runtime_ms", branching_ms).add("specialization_speedup", ms > 0 ? branching_ms / ms : 0)
+					.add("settled_per_query", (double)benches[j].settled_num / query_ids.size()).add("mismatches", benches[j].mismatch_num)
+					.add("runtime_mismatches", benches[j].runtime_mismatch_num).str() << std::endl;
+			delete benches[j].kernel;
+			delete benches[j].runtime_kernel;
+		}
+	}
+}
+
+/* Partition overlay: the partition once, the customization for the weights of the graph and again for changed weights
+(every edge scaled by a random factor in [0.5, 2], as traffic would) on 1, 2, 4... threads, and the queries vs. Dijkstra.
+The overlay paths are checked against Dijkstra, and as the first path of Yen's algorithm on the first queries. */
+void benchOverlay(Graph &graph, const std::vector<std::pair<int, int>> &query_ids, const BenchOptions &options,
+				  const std::string &graph_name, std::ostream &out)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	PartitionOverlay overlay(graph, options.overlay_cells);
+	double partition_ms = elapsedMs(start);
+	start = std::chrono::steady_clock::now();
+	overlay.customize(options.thread_num);
+	double customize_ms = elapsedMs(start);
+
+	std::ostringstream cell_sizes, cell_nums, boundary_nums;
+	long long clique_entry_num = 0;
+	for (int level = 0; level < overlay.getLevelNum(); ++level)
+	{
+		cell_sizes << (level > 0 ? "," : "") << options.overlay_cells[level];
+		cell_nums << (level > 0 ? "," : "") << overlay.getCellNum(level);
+		boundary_nums << (level > 0 ? "," : "") << overlay.getBoundaryVertexNum(level);
+		clique_entry_num += overlay.getCliqueEntryNum(level);
+	}
+
+	double ms = 0, dijkstra_ms = 0;
+	long long settled_num = 0, unpack_settled_num = 0;
+	int mismatch_num = 0, yen_mismatch_num = 0;
+	int top_k = *std::max_element(options.top_ks.begin(), options.top_ks.end());
+	for (size_t i = 0; i < query_ids.size(); ++i)
+	{
+		BaseVertex *source = graph.getVertex(query_ids[i].first);
+		BaseVertex *target = graph.getVertex(query_ids[i].second);
+		start = std::chrono::steady_clock::now();
+		BasePath *path = overlay.getShortestPath(source, target);
+		ms += elapsedMs(start);
+		settled_num += overlay.getSettledNum();
+		unpack_settled_num += overlay.getUnpackSettledNum();
+
+		start = std::chrono::steady_clock::now();
+		Dijkstra dijkstra_alg(&graph);
+		BasePath *dijkstra_path = dijkstra_alg.getShortestPath(source, target);
+		dijkstra_ms += elapsedMs(start);
+		mismatch_num += std::abs(path->Weight() - dijkstra_path->Weight()) <= 1e-9 * (1 + dijkstra_path->Weight()) ? 0 : 1;
+
+		if ((int)i < options.query_num && source != target)
+		{
+			Yen seeded_alg(graph, path);
+			Yen yen_alg(graph, source, target);
+			for (int k = 0; k < top_k && (seeded_alg.hasNext() || yen_alg.hasNext()); ++k)
+			{
+				if (seeded_alg.hasNext() != yen_alg.hasNext() || std::abs(seeded_alg.next()->Weight() - yen_alg.next()->Weight()) > 1e-9 * (1 + path->Weight()))
+				{
+					++yen_mismatch_num;
+					break;
+				}
+			}
+		}
+		delete path;
+		delete dijkstra_path;
+	}
+	out << graphRecord(options.label, graph_name, graph, "overlay").add("cell_sizes", cell_sizes.str()).add("cells", cell_nums.str())
+			.add("boundary_vertices", boundary_nums.str()).add("clique_entries", clique_entry_num).add("partition_ms", partition_ms)
+			.add("customize_ms", customize_ms).add("threads", options.thread_num).add("queries", query_ids.size()).add("ms", ms / query_ids.size())
+			.add("dijkstra_ms", dijkstra_ms / query_ids.size()).add("settled_per_query", (double)settled_num / query_ids.size())
+			.add("unpack_settled_per_query", (double)unpack_settled_num / query_ids.size()).add("mismatches", mismatch_num)
+			.add("yen_k", top_k).add("yen_mismatches", yen_mismatch_num).str() << std::endl;
+
+	std::mt19937 rng(options.seed);
+	std::uniform_real_distribution<double> factor(0.5, 2.0);
+	std::vector<double> edge_weights(overlay.getFlatGraph().getEdgeNum());
+	for (size_t e = 0; e < edge_weights.size(); ++e)
+	{
+		edge_weights[e] = overlay.getFlatGraph().outWeight(e) * factor(rng);
+	}
+	double single_thread_ms = 0;
+	for (int thread_num = 1;; thread_num = std::min(thread_num * 2, options.thread_num))
+	{
+		start = std::chrono::steady_clock::now();
+		overlay.customize(edge_weights, thread_num);
+		double changed_ms = elapsedMs(start);
+		single_thread_ms = thread_num == 1 ? changed_ms : single_thread_ms;
+		out << graphRecord(options.label, graph_name, graph, "overlay_customize").add("cell_sizes", cell_sizes.str()).add("threads", thread_num)
+				.add("ms", changed_ms).add("speedup", changed_ms > 0 ? single_thread_ms / changed_ms : 0).str() << std::endl;
+		if (thread_num >= options.thread_num)
+		{
+			break;
+		}
+	}
+}
+
+/* Constraints of a scenario, derived from the shortest path of the query so that they bite */
+PathConstraints scenarioConstraints(const std::string &scenario, BasePath *shortest_path, BaseVertex *via)
+{
+	PathConstraints constraints;
+	int hop_num = shortest_path->length() - 1;
+	if (scenario == "max_hops")
+	{
+		constraints.setMaxHopNum(hop_num);
+	}
+	else if (scenario == "forbidden")
+	{
+		for (int i = 1; i < hop_num; i += 2)
+		{
+			constraints.forbidVertex(shortest_path->getVertex(i)->getID());
+		}
+	}
+	else if (scenario == "via")
+	{
+		constraints.addVia(via->getID());
+	}
+	else if (scenario == "max_cost")
+	{
+		constraints.setMaxCost(shortest_path->Weight() * 1.02);
+	}
+	else
+	{
+		constraints.setMaxHopNum(hop_num + 2);
+		constraints.setMaxCost(shortest_path->Weight() * 1.1);
+		constraints.forbidVertex(shortest_path->getVertex(hop_num / 2)->getID());
+	}
+	return constraints;
+}
+
+/* Reference of the via points: Yen's loopless paths on the graph of the states (vertex, via points passed), written to
+the work directory, i.e. the paths of ConstrainedYen, which may come back to a vertex in a later stage only.
+The forbidden vertices and edges are left out, the target has no way out before the last via point, and the hop
+and cost limits filter the paths, up to filter_limit of them. Returns whether the filter stopped before k paths. */
+bool stagedYenDistances(Graph &graph, const PathConstraints &constraints, BaseVertex *source, BaseVertex *target, int top_k,
+						const BenchOptions &options, std::vector<double> &distances)
+{
+	FlatGraph flat_graph(graph);
+	const std::vector<int> &via_ids = constraints.getViaIds();
+	int stage_num = via_ids.size();
+	// the stage after entering a vertex, as ConstrainedYen::advanceStage
+	auto advanceStage = [&](int v, int stage) {
+		while (stage < stage_num && via_ids[stage] == flat_graph.getVertex(v)->getID())
+		{
+			++stage;
+		}
+		return stage;
+	};
+	std::ostringstream edges;
+	edges.precision(17);
+	std::set<int> state_ids;
+	for (int v = 0; v < flat_graph.getVertexNum(); ++v)
+	{
+		int start_id = flat_graph.getVertex(v)->getID();
+		for (int stage = 0; stage <= stage_num && !constraints.isForbiddenVertex(start_id); ++stage)
+		{
+			if (v == target->getIndex() && stage < stage_num)
+			{
+				continue;
+			}
+			for (int e = flat_graph.outBegin(v); e < flat_graph.outEnd(v); ++e)
+			{
+				int u = flat_graph.outTarget(e);
+				int end_id = flat_graph.getVertex(u)->getID();
+				if (constraints.isForbiddenVertex(end_id) || constraints.isForbiddenEdge(start_id, end_id))
+				{
+					continue;
+				}
+				int state = v * (stage_num + 1) + stage;
+				int next_state = u * (stage_num + 1) + advanceStage(u, stage);
+				edges << state << " " << next_state << " " << flat_graph.outWeight(e) << "\n";
+				state_ids.insert(state);
+				state_ids.insert(next_state);
+			}
+		}
+	}
+	int source_state = source->getIndex() * (stage_num + 1) + advanceStage(source->getIndex(), 0);
+	int target_state = target->getIndex() * (stage_num + 1) + stage_num;
+	distances.clear();
+	if (state_ids.find(source_state) == state_ids.end() || state_ids.find(target_state) == state_ids.end())
+	{
+		return false;
+	}
+
+	std::string file_name = options.work_dir + "/bench_staged.cfg";
+	std::ofstream ofs(file_name.c_str());
+	ofs << state_ids.size() << "\n" << edges.str();
+	ofs.close();
+	Graph staged_graph(file_name);
+	std::remove(file_name.c_str());
+
+	Yen yen_alg(staged_graph, staged_graph.getVertex(source_state), staged_graph.getVertex(target_state));
+	int popped_num = 0;
+	while (yen_alg.hasNext() && (int)distances.size() < top_k && popped_num < options.filter_limit)
+	{
+		BasePath *path = yen_alg.next();
+		++popped_num;
+		if ((constraints.getMaxHopNum() < 0 || path->length() - 1 <= constraints.getMaxHopNum()) && path->Weight() <= constraints.getMaxCost())
+		{
+			distances.push_back(path->Weight());
+		}
+	}
+	return yen_alg.hasNext() && (int)distances.size() < top_k;
+}
+
+/* Top k paths meeting constraints: Yen's output filtered, up to filter_limit paths per query, vs. the constraints
+enforced in the search. Candidates are the spur paths generated. A path may come back to a vertex after its via point
+where Yen keeps loopless paths: the paths of the via scenario are compared with stagedYenDistances instead. */
+void benchConstraints(Graph &graph, const std::vector<std::pair<BaseVertex *, BaseVertex *>> &queries, const std::vector<BaseVertex *> &vias,
+					  int top_k, const BenchOptions &options, const std::string &graph_name, std::ostream &out)
+{
+	const char *scenarios[] = {"max_hops", "forbidden", "via", "max_cost", "mixed"};
+	for (int c = 0; c < 5; ++c)
+	{
+		std::string scenario = scenarios[c];
+		double filter_ms = 0, ms = 0;
+		long long filter_candidate_num = 0, candidate_num = 0, spur_search_num = 0, pruned_spur_num = 0;
+		int query_num = 0, filter_path_num = 0, path_num = 0, truncated_num = 0, mismatch_num = 0;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			Dijkstra dijkstra_alg(&graph);
+			BasePath *shortest_path = dijkstra_alg.getShortestPath(queries[i].first, queries[i].second);
+			if (shortest_path->length() < 2 || (scenario == "via" && (vias[i] == queries[i].first || vias[i] == queries[i].second)))
+			{
+				delete shortest_path;
+				continue;
+			}
+			PathConstraints constraints = scenarioConstraints(scenario, shortest_path, vias[i]);
+			delete shortest_path;
+			++query_num;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Yen yen_alg(graph, queries[i].first, queries[i].second);
+			std::vector<double> filter_distances;
+			int popped_num = 0;
+			while (yen_alg.hasNext() && (int)filter_distances.size() < top_k && popped_num < options.filter_limit)
+			{
+				BasePath *path = yen_alg.next();
+				++popped_num;
+				if (constraints.isSatisfiedBy(path))
+				{
+					filter_distances.push_back(path->Weight());
+				}
+			}
+			filter_ms += elapsedMs(start);
+			filter_candidate_num += yen_alg.getGeneratedPathNum();
+			filter_path_num += filter_distances.size();
+			bool is_truncated = yen_alg.hasNext() && (int)filter_distances.size() < top_k;
+			truncated_num += is_truncated ? 1 : 0;
+
+			start = std::chrono::steady_clock::now();
+			ConstrainedYen constrained_alg(graph, constraints);
+			std::vector<BasePath *> result_list;
+			constrained_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, result_list);
+			ms += elapsedMs(start);
+			candidate_num += constrained_alg.getGeneratedPathNum();
+			spur_search_num += constrained_alg.getSpurSearchNum();
+			pruned_spur_num += constrained_alg.getPrunedSpurNum();
+			path_num += result_list.size();
+
+			if (scenario == "via")
+			{
+				is_truncated = stagedYenDistances(graph, constraints, queries[i].first, queries[i].second, top_k, options, filter_distances);
+			}
+			bool is_equal = is_truncated ? result_list.size() >= filter_distances.size() : result_list.size() == filter_distances.size();
+			for (size_t j = 0; j < result_list.size() && j < filter_distances.size(); ++j)
+			{
+				is_equal = is_equal && std::abs(result_list[j]->Weight() - filter_distances[j]) <= 1e-9 * (1 + filter_distances[j]);
+			}
+			mismatch_num += is_equal ? 0 : 1;
+		}
+		out << graphRecord(options.label, graph_name, graph, "constraints").add("scenario", scenario).add("k", top_k).add("queries", query_num)
+				.add("filter_ms", query_num > 0 ? filter_ms / query_num : 0).add("filter_candidates", filter_candidate_num)
+				.add("filter_paths", filter_path_num).add("filter_truncated", truncated_num)
+				.add("ms", query_num > 0 ? ms / query_num : 0).add("candidates", candidate_num).add("spur_searches", spur_search_num)
+				.add("pruned_spurs", pruned_spur_num).add("paths", path_num).add("mismatches", mismatch_num).str() << std::endl;
+	}
+}
+
+/* Yen's algorithm with the reverse tree repaired at every iteration vs. built anew. Repaired vertices are the ones searched again
+per iteration, to compare with the vertices of the graph a new tree settles. */
+void benchYenTree(Graph &graph, const std::vector<std::pair<BaseVertex *, BaseVertex *>> &queries, const BenchOptions &options,
+				  const std::string &graph_name, std::ostream &out)
+{
+	for (size_t k = 0; k < options.top_ks.size(); ++k)
+	{
+		int top_k = options.top_ks[k];
+		double ms = 0, rebuild_ms = 0;
+		long long path_num = 0, repaired_num = 0;
+		int mismatch_num = 0;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Yen yen_alg(graph);
+			std::vector<BasePath *> result_list;
+			yen_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, result_list);
+			ms += elapsedMs(start);
+			path_num += result_list.size();
+			repaired_num += yen_alg.getRepairedVertexNum();
+
+			start = std::chrono::steady_clock::now();
+			Yen rebuild_alg(graph);
+			rebuild_alg.setTreeReuse(false);
+			std::vector<BasePath *> rebuild_result_list;
+			rebuild_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, rebuild_result_list);
+			rebuild_ms += elapsedMs(start);
+			bool is_equal = rebuild_result_list.size() == result_list.size();
+			for (size_t j = 0; is_equal && j < result_list.size(); ++j)
+			{
+				is_equal = std::abs(rebuild_result_list[j]->Weight() - result_list[j]->Weight()) <= 1e-9 * (1 + result_list[j]->Weight());
+			}
+			mismatch_num += is_equal ? 0 : 1;
+		}
+		out << graphRecord(options.label, graph_name, graph, "yen_tree").add("k", top_k).add("queries", queries.size())
+				.add("ms", ms / queries.size()).add("rebuild_ms", rebuild_ms / queries.size()).add("paths", path_num)
+				.add("repaired_per_iteration", path_num > 0 ? (double)repaired_num / path_num : 0).add("mismatches", mismatch_num).str() << std::endl;
+	}
+}
+
+/* Node classification vs. Yen's algorithm, Yen being run up to yen_limit paths. The two engines give the same distances,
+and the same paths but for the order of equal-cost ones. Tree spurs are the spurs answered without settling a yellow vertex. */
+void benchFeng(Graph &graph, const std::vector<std::pair<BaseVertex *, BaseVertex *>> &queries, const BenchOptions &options,
+			   const std::string &graph_name, std::ostream &out)
+{
+	for (size_t k = 0; k < options.feng_ks.size(); ++k)
+	{
+		int top_k = options.feng_ks[k];
+		bool has_yen = top_k <= options.yen_limit;
+		double ms = 0, yen_ms = 0;
+		long long path_num = 0, candidate_num = 0, tree_spur_num = 0, yellow_settled_num = 0;
+		int mismatch_num = 0;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Feng feng_alg(graph);
+			std::vector<BasePath *> result_list;
+			feng_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, result_list);
+			ms += elapsedMs(start);
+			path_num += result_list.size();
+			candidate_num += feng_alg.getGeneratedPathNum();
+			tree_spur_num += feng_alg.getTreeSpurNum();
+			yellow_settled_num += feng_alg.getYellowSettledNum();
+			if (!has_yen)
+			{
+				continue;
+			}
+
+			start = std::chrono::steady_clock::now();
+			Yen yen_alg(graph);
+			std::vector<BasePath *> yen_result_list;
+			yen_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, yen_result_list);
+			yen_ms += elapsedMs(start);
+			bool is_equal = yen_result_list.size() == result_list.size();
+			for (size_t j = 0; is_equal && j < result_list.size(); ++j)
+			{
+				is_equal = std::abs(yen_result_list[j]->Weight() - result_list[j]->Weight()) <= 1e-9 * (1 + result_list[j]->Weight());
+			}
+			mismatch_num += is_equal ? 0 : 1;
+		}
+		BenchRecord record = graphRecord(options.label, graph_name, graph, "feng");
+		record.add("k", top_k).add("queries", queries.size()).add("ms", ms / queries.size()).add("paths", path_num)
+			.add("candidates", candidate_num).add("tree_spurs", tree_spur_num).add("yellow_settled", yellow_settled_num);
+		if (has_yen)
+		{
+			record.add("yen_ms", yen_ms / queries.size()).add("mismatches", mismatch_num);
+		}
+		out << record.str() << std::endl;
+	}
+}
+
+/* Shortest walks by Eppstein's algorithm. Loopless walks are the ones Yen's algorithm would return as well. */
+void benchEppstein(Graph &graph, const std::vector<std::pair<BaseVertex *, BaseVertex *>> &queries, const BenchOptions &options,
+				   const std::string &graph_name, std::ostream &out)
+{
+	for (size_t k = 0; k < options.eppstein_ks.size(); ++k)
+	{
+		int top_k = options.eppstein_ks[k];
+		double ms = 0, length_sum = 0;
+		long long walk_num = 0, loopless_num = 0, heap_node_num = 0;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Eppstein eppstein_alg(graph);
+			std::vector<BasePath *> result_list;
+			eppstein_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, result_list);
+			ms += elapsedMs(start);
+			walk_num += result_list.size();
+			heap_node_num += eppstein_alg.getHeapNodeNum();
+			for (size_t j = 0; j < result_list.size(); ++j)
+			{
+				std::set<BaseVertex *> vertex_set;
+				for (int l = 0; l < result_list[j]->length(); ++l)
+				{
+					vertex_set.insert(result_list[j]->getVertex(l));
+				}
+				length_sum += result_list[j]->length() - 1;
+				loopless_num += (int)vertex_set.size() == result_list[j]->length() ? 1 : 0;
+			}
+		}
+		out << graphRecord(options.label, graph_name, graph, "eppstein").add("k", top_k).add("queries", queries.size())
+				.add("ms", ms / queries.size()).add("walks", walk_num).add("loopless_walks", loopless_num)
+				.add("mean_hops", walk_num > 0 ? length_sum / walk_num : 0).add("heap_nodes", heap_node_num).str() << std::endl;
+	}
+}
+
+void benchGraph(const std::string &graph_name, const std::string &file_name, const BenchOptions &options, std::ostream &out)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Graph graph(file_name);
+	double load_ms = elapsedMs(start);
+	int vertex_num = graph.getVertexNum();
+	const std::vector<BaseVertex *> &vertices = graph.getVertexList();
+
+	out << graphRecord(options.label, graph_name, graph, "load").add("ms", load_ms).str() << std::endl;
+
+	// the same random queries for every algorithm
+	std::mt19937 rng(options.seed);
+	std::uniform_int_distribution<int> pick(0, vertex_num - 1);
+	std::vector<std::pair<BaseVertex *, BaseVertex *>> queries;
+	for (int i = 0; i < options.query_num; ++i)
+	{
+		queries.push_back(std::make_pair(vertices[pick(rng)], vertices[pick(rng)]));
+	}
+
+	start = std::chrono::steady_clock::now();
+	double total_distance = 0;
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		Dijkstra dijkstra_alg(&graph);
+		BasePath *path = dijkstra_alg.getShortestPath(queries[i].first, queries[i].second);
+		total_distance += path->Weight() < Graph::DISCONNECT ? path->Weight() : 0;
+		delete path;
+	}
+	out << graphRecord(options.label, graph_name, graph, "dijkstra").add("queries", queries.size()).add("ms", elapsedMs(start) / queries.size())
+			.add("total_distance", total_distance).str() << std::endl;
+
+	for (size_t k = 0; k < options.top_ks.size(); ++k)
+	{
+		int top_k = options.top_ks[k];
+		int path_num = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			std::ostringstream query_name;
+			query_name << graph_name << " yen " << queries[i].first->getID() << "->" << queries[i].second->getID() << " k=" << top_k;
+			INSTRUMENT_BEGIN_QUERY(query_name.str());
+			Yen yen_alg(graph, NULL, NULL);
+			std::vector<BasePath *> result_list;
+			yen_alg.getShortestPaths(queries[i].first, queries[i].second, top_k, result_list);
+			path_num += result_list.size();
+			INSTRUMENT_END_QUERY();
+		}
+		out << graphRecord(options.label, graph_name, graph, "yen").add("k", top_k).add("queries", queries.size()).add("ms", elapsedMs(start) / queries.size())
+				.add("paths", path_num).str() << std::endl;
+	}
+
+	benchYenTree(graph, queries, options, graph_name, out);
+	benchFeng(graph, queries, options, graph_name, out);
+	benchEppstein(graph, queries, options, graph_name, out);
+
+	std::vector<BaseVertex *> vias;
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		vias.push_back(vertices[pick(rng)]);
+	}
+	benchConstraints(graph, queries, vias, *std::max_element(options.top_ks.begin(), options.top_ks.end()), options, graph_name, out);
+
+	// the max flow works on a dense capacity matrix
+	if (vertex_num <= options.max_flow_limit)
+	{
+		BenchRecord record = graphRecord(options.label, graph_name, graph, "maxflow");
+		benchMaxFlow(graph, queries[0].first, queries[0].second, record);
+		out << record.str() << std::endl;
+	}
+
+	std::vector<BaseVertex *> matrix_vertices;
+	for (int i = 0; i < 64 && i < vertex_num; ++i)
+	{
+		matrix_vertices.push_back(vertices[pick(rng)]);
+	}
+	benchDeltaStepping(graph, queries[0].second, options, graph_name, out);
+
+	BenchRecord int_record = graphRecord(options.label, graph_name, graph, "integer_weights");
+	benchIntegerWeights(graph, file_name, queries, options.weight_unit, int_record);
+	out << int_record.str() << std::endl;
+
+	std::vector<std::pair<int, int>> query_ids;
+	for (int i = 0; i < 64; ++i)
+	{
+		query_ids.push_back(std::make_pair(vertices[pick(rng)]->getID(), vertices[pick(rng)]->getID()));
+	}
+	benchVertexOrder(graph_name, file_name, query_ids, options, out);
+	benchSearchKernel(graph_name, file_name, query_ids, options, out);
+	benchOverlay(graph, query_ids, options, graph_name, out);
+	query_ids.resize(queries.size());
+	benchStorage(graph_name, file_name, query_ids, options, out);
+
+	BenchRecord record = graphRecord(options.label, graph_name, graph, "many2many");
+	benchManyToMany(graph, matrix_vertices, options.thread_num, record);
+	out << record.str() << std::endl;
+}
+
+void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+			  << "  --graph <file>        benchmark an existing graph file instead of generated ones\n"
+			  << "  --kinds <a,b>         generated graph kinds among grid,geometric,scalefree\n"
+			  << "  --edges <n1,n2>       number of directed edges of the generated graphs (up to 10^7)\n"
+			  << "  --k <k1,k2>           values of k for Yen's algorithm\n"
+			  << "  --feng-k <k1,k2>      values of k for the node classification engine\n"
+			  << "  --yen-limit <k>       largest k Yen's algorithm is compared with it\n"
+			  << "  --eppstein-k <k1,k2>  values of k for the shortest walks\n"
+			  << "  --overlay-cells <n,m> largest cell of each level of the partition overlay, finest first\n"
+			  << "  --queries <n>         number of random queries per graph\n"
+			  << "  --threads <n>         worker threads of the parallel algorithms\n"
+			  << "  --maxflow-limit <n>   largest graph for the dense max flow\n"
+			  << "  --filter-limit <n>    paths of Yen filtered by the constraints per query at most\n"
+			  << "  --weight-unit <km>    unit of the integer weight mode\n"
+			  << "  --seed <n>            seed of the generators and of the queries\n"
+			  << "  --workdir <dir>       where the generated graphs are written\n"
+			  << "  --label <text>        tag of every record, e.g. the release\n"
+			  << "  --out <file>          append the records to a file instead of the standard output\n"
+			  << "  --profile <file>      JSON summary of the Yen queries (build with -DDSC_INSTRUMENT)\n"
+			  << "  --trace <file>        Chrome trace events of the Yen queries (build with -DDSC_INSTRUMENT)\n"
+			  << "   or: " << program << " --generate <kind> <edge_num> <file> [seed]\n";
+}
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	options.kinds = splitList("grid,geometric,scalefree");
+	options.edge_nums.push_back(10000);
+	options.edge_nums.push_back(100000);
+	options.top_ks.push_back(1);
+	options.top_ks.push_back(10);
+	options.top_ks.push_back(50);
+	options.feng_ks.push_back(10);
+	options.feng_ks.push_back(100);
+	options.feng_ks.push_back(1000);
+	options.feng_ks.push_back(10000);
+	options.yen_limit = 100;
+	options.eppstein_ks.push_back(1000);
+	options.eppstein_ks.push_back(100000);
+	options.overlay_cells.push_back(256);
+	options.overlay_cells.push_back(4096);
+	options.query_num = 3;
+	options.thread_num = std::max(1, (int)std::thread::hardware_concurrency());
+	options.max_flow_limit = 1000;
+	options.filter_limit = 100;
+	options.weight_unit = 0.001;
+	options.seed = 2024;
+	options.work_dir = ".";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--generate" && i + 3 < argc)
+		{
+			GraphGenerator generator(i + 4 < argc ? atoi(argv[i + 4]) : options.seed);
+			generator.writeByEdgeNum(argv[i + 3], argv[i + 1], atoll(argv[i + 2]));
+			return 0;
+		}
+		else if (arg == "--graph" && has_value)
+		{
+			options.graph_file = argv[++i];
+		}
+		else if (arg == "--kinds" && has_value)
+		{
+			options.kinds = splitList(argv[++i]);
+		}
+		else if (arg == "--edges" && has_value)
+		{
+			std::vector<std::string> items = splitList(argv[++i]);
+			options.edge_nums.clear();
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				options.edge_nums.push_back(atoll(items[j].c_str()));
+			}
+		}
+		else if (arg == "--k" && has_value)
+		{
+			std::vector<std::string> items = splitList(argv[++i]);
+			options.top_ks.clear();
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				options.top_ks.push_back(atoi(items[j].c_str()));
+			}
+		}
+		else if (arg == "--feng-k" && has_value)
+		{
+			std::vector<std::string> items = splitList(argv[++i]);
+			options.feng_ks.clear();
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				options.feng_ks.push_back(atoi(items[j].c_str()));
+			}
+		}
+		else if (arg == "--eppstein-k" && has_value)
+		{
+			std::vector<std::string> items = splitList(argv[++i]);
+			options.eppstein_ks.clear();
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				options.eppstein_ks.push_back(atoi(items[j].c_str()));
+			}
+		}
+		else if (arg == "--overlay-cells" && has_value)
+		{
+			std::vector<std::string> items = splitList(argv[++i]);
+			options.overlay_cells.clear();
+			for (size_t j = 0; j < items.size(); ++j)
+			{
+				options.overlay_cells.push_back(atoi(items[j].c_str()));
+			}
+		}
+		else if (arg == "--yen-limit" && has_value)
+		{
+			options.yen_limit = atoi(argv[++i]);
+		}
+		else if (arg == "--queries" && has_value)
+		{
+			options.query_num = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--threads" && has_value)
+		{
+			options.thread_num = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--maxflow-limit" && has_value)
+		{
+			options.max_flow_limit = atoi(argv[++i]);
+		}
+		else if (arg == "--filter-limit" && has_value)
+		{
+			options.filter_limit = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--weight-unit" && has_value)
+		{
+			options.weight_unit = atof(argv[++i]);
+		}
+		else if (arg == "--seed" && has_value)
+		{
+			options.seed = atoi(argv[++i]);
+		}
+		else if (arg == "--workdir" && has_value)
+		{
+			options.work_dir = argv[++i];
+		}
+		else if (arg == "--label" && has_value)
+		{
+			options.label = argv[++i];
+		}
+		else if (arg == "--out" && has_value)
+		{
+			options.out_file = argv[++i];
+		}
+		else if (arg == "--profile" && has_value)
+		{
+			options.profile_file = argv[++i];
+		}
+		else if (arg == "--trace" && has_value)
+		{
+			options.trace_file = argv[++i];
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::ofstream out_file;
+	if (!options.out_file.empty())
+	{
+		out_file.open(options.out_file.c_str(), std::ios::app);
+		if (!out_file)
+		{
+			std::cerr << "The file " << options.out_file << " can not be opened!" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &out = options.out_file.empty() ? std::cout : out_file;
+	Instrument::enableTrace(!options.trace_file.empty());
+
+	if (!options.graph_file.empty())
+	{
+		benchGraph(options.graph_file, options.graph_file, options, out);
+	}
+	GraphGenerator generator(options.seed);
+	for (size_t i = 0; i < options.kinds.size() && options.graph_file.empty(); ++i)
+	{
+		for (size_t j = 0; j < options.edge_nums.size(); ++j)
+		{
+			std::ostringstream graph_name;
+			graph_name << options.kinds[i] << "_" << options.edge_nums[j];
+			std::string file_name = options.work_dir + "/bench_" + graph_name.str() + ".cfg";
+			std::cerr << "[BENCH] " << graph_name.str() << std::endl;
+			generator.writeByEdgeNum(file_name, options.kinds[i], options.edge_nums[j]);
+			benchGraph(graph_name.str(), file_name, options, out);
+			std::remove(file_name.c_str());
+		}
+	}
+
+	if (!options.profile_file.empty())
+	{
+		std::ofstream profile_file(options.profile_file.c_str());
+		Instrument::writeSummary(profile_file);
+	}
+	if (!options.trace_file.empty())
+	{
+		std::ofstream trace_file(options.trace_file.c_str());
+		Instrument::writeTrace(trace_file);
+	}
+	return 0;
+}
@@ -0,0 +1,262 @@
+#include "main.h"
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <condition_variable>
+#include "LineSocket.h"
+
+/* Load generator of the query server: every connection keeps up to pipeline_depth requests in flight,
+the latency of a request runs from its sending to its answer. */
+struct LoadOptions
+{
+	std::string 	socket_path;
+	int 			port;
+	std::string 	graph_file;
+	int 			connection_num;
+	int 			request_num;
+	int 			pipeline_depth;
+	int 			top_k;
+	int 			max_flow_every;
+	unsigned int 	seed;
+	std::string 	label;
+};
+
+struct ConnectionResult
+{
+	std::vector<double> 	latencies_ms;
+	int 					error_num;
+};
+
+/* Node IDs of the graph file, to draw the queries from */
+void readNodeIds(const std::string &file_name, std::vector<int> &node_ids)
+{
+	std::ifstream ifs(file_name.c_str());
+	if (!ifs)
+	{
+		std::cerr << "The file " << file_name << " can not be opened!" << std::endl;
+		exit(1);
+	}
+	int vertex_num, start_vertex, end_vertex;
+	double edge_weight;
+	std::set<int> id_set;
+	ifs >> vertex_num;
+	while (ifs >> start_vertex && start_vertex != -1 && ifs >> end_vertex >> edge_weight)
+	{
+		id_set.insert(start_vertex);
+		id_set.insert(end_vertex);
+	}
+	node_ids.assign(id_set.begin(), id_set.end());
+}
+
+void runConnection(const LoadOptions &options, const std::vector<std::string> &requests, ConnectionResult &result)
+{
+	LineSocket socket(options.port > 0 ? LineSocket::connectTcp(options.port) : LineSocket::connectUnix(options.socket_path));
+	std::mutex mutex;
+	std::condition_variable slot_condition;
+	std::deque<std::chrono::steady_clock::time_point> send_times;
+	bool is_closed = false;
+
+	std::thread sender([&]() {
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				slot_condition.wait(lock, [&]() { return is_closed || (int)send_times.size() < options.pipeline_depth; });
+				if (is_closed)
+				{
+					return;
+				}
+				send_times.push_back(std::chrono::steady_clock::now());
+			}
+			if (!socket.writeAll(requests[i]))
+			{
+				return;
+			}
+		}
+	});
+
+	result.error_num = 0;
+	std::string line;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (!socket.readLine(line))
+		{
+			// the server is gone: the requests left count as errors
+			result.error_num += requests.size() - i;
+			break;
+		}
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			result.latencies_ms.push_back(std::chrono::duration<double, std::milli>(now - send_times.front()).count());
+			send_times.pop_front();
+		}
+		slot_condition.notify_one();
+		if (line.find("\"error\"") != std::string::npos)
+		{
+			++result.error_num;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		is_closed = true;
+	}
+	slot_condition.notify_one();
+	socket.shutdownWrite();
+	sender.join();
+}
+
+double percentile(const std::vector<double> &sorted_values, double fraction)
+{
+	if (sorted_values.empty())
+	{
+		return 0;
+	}
+	size_t rank = (size_t)(fraction * (sorted_values.size() - 1) + 0.5);
+	return sorted_values[std::min(rank, sorted_values.size() - 1)];
+}
+
+void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+			  << "  --socket <path>       Unix-domain socket of the server (default dsc_server.sock)\n"
+			  << "  --port <n>            loopback TCP port of the server instead\n"
+			  << "  --graph <file>        graph served, to draw the queries from\n"
+			  << "  --connections <n>     concurrent connections\n"
+			  << "  --requests <n>        requests over all the connections\n"
+			  << "  --pipeline <n>        requests in flight per connection\n"
+			  << "  --k <n>               k of the KSP requests\n"
+			  << "  --maxflow-every <n>   every n-th request is a MAXFLOW one, 0 for none\n"
+			  << "  --seed <n>            seed of the queries\n"
+			  << "  --label <text>        tag of the record\n";
+}
+
+int main(int argc, char *argv[])
+{
+	LoadOptions options;
+	options.socket_path = "dsc_server.sock";
+	options.port = 0;
+	options.graph_file = "data/graph_AnSuong_SGZoo.cfg";
+	options.connection_num = 4;
+	options.request_num = 1000;
+	options.pipeline_depth = 8;
+	options.top_k = 5;
+	options.max_flow_every = 0;
+	options.seed = 2024;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "--socket")
+		{
+			options.socket_path = value;
+		}
+		else if (option == "--port")
+		{
+			options.port = atoi(value.c_str());
+		}
+		else if (option == "--graph")
+		{
+			options.graph_file = value;
+		}
+		else if (option == "--connections")
+		{
+			options.connection_num = std::max(1, atoi(value.c_str()));
+		}
+		else if (option == "--requests")
+		{
+			options.request_num = std::max(1, atoi(value.c_str()));
+		}
+		else if (option == "--pipeline")
+		{
+			options.pipeline_depth = std::max(1, atoi(value.c_str()));
+		}
+		else if (option == "--k")
+		{
+			options.top_k = std::max(1, atoi(value.c_str()));
+		}
+		else if (option == "--maxflow-every")
+		{
+			options.max_flow_every = std::max(0, atoi(value.c_str()));
+		}
+		else if (option == "--seed")
+		{
+			options.seed = atoi(value.c_str());
+		}
+		else if (option == "--label")
+		{
+			options.label = value;
+		}
+		else
+		{
+			argc = 0;
+		}
+	}
+	if (argc % 2 != 1)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	// the same random requests for a given seed, dealt out to the connections in turn
+	std::vector<int> node_ids;
+	readNodeIds(options.graph_file, node_ids);
+	if (node_ids.size() < 2)
+	{
+		std::cerr << "The graph has too few vertices." << std::endl;
+		return 1;
+	}
+	std::mt19937 rng(options.seed);
+	std::uniform_int_distribution<size_t> pick(0, node_ids.size() - 1);
+	std::vector<std::vector<std::string>> requests(options.connection_num);
+	for (int i = 0; i < options.request_num; ++i)
+	{
+		int source_id = node_ids[pick(rng)];
+		int target_id = node_ids[pick(rng)];
+		while (target_id == source_id)
+		{
+			target_id = node_ids[pick(rng)];
+		}
+		std::ostringstream request;
+		if (options.max_flow_every > 0 && i % options.max_flow_every == options.max_flow_every - 1)
+		{
+			request << "MAXFLOW " << source_id << ' ' << target_id << '\n';
+		}
+		else
+		{
+			request << "KSP " << source_id << ' ' << target_id << ' ' << options.top_k << '\n';
+		}
+		requests[i % options.connection_num].push_back(request.str());
+	}
+
+	std::vector<ConnectionResult> results(options.connection_num);
+	std::vector<std::thread> connections;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < options.connection_num; ++i)
+	{
+		connections.push_back(std::thread(runConnection, std::cref(options), std::cref(requests[i]), std::ref(results[i])));
+	}
+	for (size_t i = 0; i < connections.size(); ++i)
+	{
+		connections[i].join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<double> latencies_ms;
+	int error_num = 0;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		latencies_ms.insert(latencies_ms.end(), results[i].latencies_ms.begin(), results[i].latencies_ms.end());
+		error_num += results[i].error_num;
+	}
+	std::sort(latencies_ms.begin(), latencies_ms.end());
+	std::cout << "{\"case\":\"server\",\"label\":\"" << options.label << "\",\"connections\":" << options.connection_num
+			  << ",\"pipeline\":" << options.pipeline_depth << ",\"k\":" << options.top_k << ",\"requests\":" << options.request_num
+			  << ",\"answers\":" << latencies_ms.size() << ",\"errors\":" << error_num << ",\"seconds\":" << seconds
+			  << ",\"throughput\":" << latencies_ms.size() / seconds << ",\"p50_ms\":" << percentile(latencies_ms, 0.5)
+			  << ",\"p90_ms\":" << percentile(latencies_ms, 0.9) << ",\"p99_ms\":" << percentile(latencies_ms, 0.99)
+			  << ",\"p999_ms\":" << percentile(latencies_ms, 0.999) << ",\"max_ms\":" << (latencies_ms.empty() ? 0 : latencies_ms.back()) << "}" << std::endl;
+	return error_num > 0 ? 1 : 0;
+}
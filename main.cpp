@@ -3,61 +3,17 @@
 #include "Graph.h"
 #include "Dijkstra.h"
 #include "Yen.h"
+#include "FlatGraph.h"
+#include "PartitionOverlay.h"
+#include "PathConstraints.h"
+#include "ConstrainedYen.h"
+#include "Feng.h"
+#include "Eppstein.h"
+#include "MaxFlow.h"
+#include "Instrument.h"
 
 #define TOP_K 5
 
-bool PushRelabel_canPush(std::vector<std::vector<int>> &capacity, int src, int sink, std::vector<int> &parent)
-{
-	int N = capacity.size();
-	std::vector<int> vis(N, 0);
-	vis[src] = 1;
-	parent[src] = -1;
-	std::queue<int> q;
-	q.push(src);
-	while (!q.empty())
-	{
-		int cnode = q.front();
-		q.pop();
-		for (int i = 0; i < N; i++)
-		{
-			if (vis[i] == 0 && capacity[cnode][i] > 0)
-			{
-				vis[i] = 1;
-				parent[i] = cnode;
-				q.push(i);
-			}
-		}
-	}
-	if (vis[sink])
-		return true;
-	return false;
-}
-
-int PushRelabel_FIFO(std::vector<std::vector<int>> &capacity, int src, int sink)
-{
-	int N = capacity.size();
-	std::vector<int> parent(N);
-	int max_flow = 0;
-	while (PushRelabel_canPush(capacity, src, sink, parent))
-	{
-		int curr_flow = INT_MAX;
-		int temp = sink;
-		while (temp != src)
-		{
-			curr_flow = std::min(curr_flow, capacity[parent[temp]][temp]);
-			temp = parent[temp];
-		}
-		temp = sink;
-		while (temp != src)
-		{
-			capacity[parent[temp]][temp] -= curr_flow;
-			temp = parent[temp];
-		}
-		max_flow += curr_flow;
-	}
-	return max_flow;
-}
-
 int PushRelabel_dev(int src, int sink)
 {
 	std::vector<std::vector<int>> capacity_abs = {
@@ -80,10 +36,37 @@ void testDijkstra() // testing only
 	result->printOut(std::cout);
 }
 
-void runDSC(const std::string &cfg_filename)
+/* Node IDs separated by commas, pairs of them joined by a dash, e.g. "12,13" or "3-39,40-41" */
+std::vector<int> parseIdList(const std::string &text)
+{
+	std::vector<int> ids;
+	std::istringstream iss(text);
+	std::string item;
+	while (std::getline(iss, item, ','))
+	{
+		std::istringstream item_stream(item);
+		std::string node_id;
+		while (std::getline(item_stream, node_id, '-'))
+		{
+			ids.push_back(atoi(node_id.c_str()));
+		}
+	}
+	return ids;
+}
+
+void runDSC(const std::string &cfg_filename, double weight_unit, Graph::VertexOrder vertex_order, bool is_compact, const std::string &memory_filename,
+			const PathConstraints &constraints, const std::string &ksp_engine, bool is_kernel_search,
+			const std::vector<int> &overlay_cells)
 {
 	// create graph
-	Graph my_graph("data/graph_AnSuong_SGZoo.cfg");
+	INSTRUMENT_BEGIN_QUERY("load data/graph_AnSuong_SGZoo.cfg");
+	Graph my_graph("data/graph_AnSuong_SGZoo.cfg", weight_unit, vertex_order, is_compact);
+	INSTRUMENT_END_QUERY();
+	if (!memory_filename.empty())
+	{
+		std::ofstream memory_file(memory_filename.c_str());
+		my_graph.printMemoryFootprint(memory_file);
+	}
 
 	// get input
 	int begin_point;
@@ -107,7 +90,7 @@ void runDSC(const std::string &cfg_filename)
 		std::cerr << "Invalid format in configuration file." << std::endl;
 		return;
 	}
-	if (tempX < 0 || tempX > 50 || tempY < 1 || tempY > 51 || tempY <= tempX)
+	if (my_graph.getInternalIndex(tempX) < 0 || my_graph.getInternalIndex(tempY) < 0 || tempY == tempX)
 	{
 		std::cerr << "Values of x and y are out of range or invalid." << std::endl;
 		return;
@@ -116,26 +99,197 @@ void runDSC(const std::string &cfg_filename)
 	end_point = tempY;
 
 	// run Yen's algorithm for top k shortest paths
+	std::ostringstream query_name;
+	query_name << "yen " << begin_point << "->" << end_point << " k=" << TOP_K;
+	INSTRUMENT_BEGIN_QUERY(query_name.str());
+	if (!constraints.isEmpty())
+	{
+		// the constraints are enforced during the search: there may be fewer than k paths meeting them
+		ConstrainedYen constrained_alg(my_graph, constraints, my_graph.getVertex(begin_point), my_graph.getVertex(end_point));
+		for (int i = 0; i < TOP_K && constrained_alg.hasNext(); ++i)
+		{
+			constrained_alg.next()->printOut(std::cout);
+		}
+		INSTRUMENT_END_QUERY();
+		return;
+	}
+	if (ksp_engine == "feng")
+	{
+		Feng feng_alg(my_graph, my_graph.getVertex(begin_point), my_graph.getVertex(end_point));
+		for (int i = 0; i < TOP_K && feng_alg.hasNext(); ++i)
+		{
+			feng_alg.next()->printOut(std::cout);
+		}
+		INSTRUMENT_END_QUERY();
+		return;
+	}
+	if (ksp_engine == "eppstein")
+	{
+		// shortest walks: a walk may come back to a vertex
+		Eppstein eppstein_alg(my_graph, my_graph.getVertex(begin_point), my_graph.getVertex(end_point));
+		for (int i = 0; i < TOP_K && eppstein_alg.hasNext(); ++i)
+		{
+			eppstein_alg.next()->printOut(std::cout);
+		}
+		INSTRUMENT_END_QUERY();
+		return;
+	}
+	if (!overlay_cells.empty())
+	{
+		// the first path comes from the partition overlay, the next ones from Yen's deviations
+		PartitionOverlay overlay(my_graph, overlay_cells);
+		overlay.customize();
+		BasePath *first_path = overlay.getShortestPath(my_graph.getVertex(begin_point), my_graph.getVertex(end_point));
+		Yen overlay_alg(my_graph, first_path);
+		delete first_path;
+		overlay_alg.setKernelSearch(is_kernel_search);
+		for (int i = 0; i < TOP_K && overlay_alg.hasNext(); ++i)
+		{
+			overlay_alg.next()->printOut(std::cout);
+		}
+		INSTRUMENT_END_QUERY();
+		return;
+	}
 	Yen yenAlg(my_graph, my_graph.getVertex(begin_point), my_graph.getVertex(end_point));
+	yenAlg.setKernelSearch(is_kernel_search);
 	int i = 0;
 	while (i < TOP_K)
 	{
 		++i;
 		yenAlg.next()->printOut(std::cout);
 	}
+	INSTRUMENT_END_QUERY();
 }
 
 int main(int argc, char *argv[])
 {
-	if (argc != 2)
+	// optional: --weight-unit <km> for the integer weight mode, --vertex-order <bfs|rcm> for the storage order,
+	/// --storage compact for the packed graph, --memory <report_file> for its memory footprint,
+	/// --profile <summary_file> --trace <trace_file> for a build with -DDSC_INSTRUMENT,
+	/// --max-hops <n> --max-cost <km> --forbid <id,id> --forbid-edge <id-id,id-id> --via <id,id> for constrained paths,
+	/// --ksp feng for the node classification engine instead of Yen's, --ksp eppstein for the shortest walks,
+	/// --search kernel for the reverse trees of Yen's algorithm by the search kernel of the weight mode,
+	/// --overlay <n1,n2> for the first path of Yen's algorithm from a partition overlay with these cell sizes
+	std::string profile_fileName, trace_fileName, memory_fileName, ksp_engine = "yen";
+	bool is_kernel_search = false;
+	std::vector<int> overlay_cells;
+	double weight_unit = 0;
+	Graph::VertexOrder vertex_order = Graph::ORDER_FIRST_SEEN;
+	bool is_compact = false;
+	PathConstraints constraints;
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		if (option == "--weight-unit")
+		{
+			weight_unit = atof(argv[i + 1]);
+		}
+		else if (option == "--vertex-order" && std::string(argv[i + 1]) == "bfs")
+		{
+			vertex_order = Graph::ORDER_BFS;
+		}
+		else if (option == "--vertex-order" && std::string(argv[i + 1]) == "rcm")
+		{
+			vertex_order = Graph::ORDER_RCM;
+		}
+		else if (option == "--storage" && std::string(argv[i + 1]) == "compact")
+		{
+			is_compact = true;
+		}
+		else if (option == "--ksp" && (std::string(argv[i + 1]) == "yen" || std::string(argv[i + 1]) == "feng" || std::string(argv[i + 1]) == "eppstein"))
+		{
+			ksp_engine = argv[i + 1];
+		}
+		else if (option == "--search" && (std::string(argv[i + 1]) == "kernel" || std::string(argv[i + 1]) == "dijkstra"))
+		{
+			is_kernel_search = std::string(argv[i + 1]) == "kernel";
+		}
+		else if (option == "--overlay")
+		{
+			overlay_cells = parseIdList(argv[i + 1]);
+		}
+		else if (option == "--memory")
+		{
+			memory_fileName = argv[i + 1];
+		}
+		else if (option == "--max-hops")
+		{
+			constraints.setMaxHopNum(atoi(argv[i + 1]));
+		}
+		else if (option == "--max-cost")
+		{
+			constraints.setMaxCost(atof(argv[i + 1]));
+		}
+		else if (option == "--forbid")
+		{
+			std::vector<int> ids = parseIdList(argv[i + 1]);
+			for (size_t j = 0; j < ids.size(); ++j)
+			{
+				constraints.forbidVertex(ids[j]);
+			}
+		}
+		else if (option == "--forbid-edge")
+		{
+			std::vector<int> ids = parseIdList(argv[i + 1]);
+			for (size_t j = 0; j + 1 < ids.size(); j += 2)
+			{
+				constraints.forbidEdge(ids[j], ids[j + 1]);
+			}
+		}
+		else if (option == "--via")
+		{
+			std::vector<int> ids = parseIdList(argv[i + 1]);
+			for (size_t j = 0; j < ids.size(); ++j)
+			{
+				constraints.addVia(ids[j]);
+			}
+		}
+		else if (option == "--profile")
+		{
+			profile_fileName = argv[i + 1];
+		}
+		else if (option == "--trace")
+		{
+			trace_fileName = argv[i + 1];
+		}
+		else
+		{
+			argc = 0;
+		}
+	}
+	if (argc < 2 || argc % 2 != 0)
 	{
 		std::cout << "The input arguments are wrong. Please try again.\n";
 		return 1;
 	}
+	if (!constraints.isEmpty() && (ksp_engine != "yen" || is_kernel_search || !overlay_cells.empty()))
+	{
+		std::cout << "The constrained paths have their own search, they do not combine with --ksp, --search kernel or --overlay.\n";
+		return 1;
+	}
+#ifndef DSC_INSTRUMENT
+	if (!profile_fileName.empty() || !trace_fileName.empty())
+	{
+		std::cout << "The program is built without instrumentation, rebuild it with -DDSC_INSTRUMENT.\n";
+		return 1;
+	}
+#endif
+	Instrument::enableTrace(!trace_fileName.empty());
+
 	std::cout << "MAX FLOW: " << PushRelabel_dev(0, TOP_K) << '\n'; // in development state
 	std::cout << "TOP " << TOP_K << " SHORTEST PATHS:\n";
 	std::string cfg_fileName = argv[1];
-	runDSC(cfg_fileName);
+	runDSC(cfg_fileName, weight_unit, vertex_order, is_compact, memory_fileName, constraints, ksp_engine, is_kernel_search, overlay_cells);
 
+	if (!profile_fileName.empty())
+	{
+		std::ofstream profile_file(profile_fileName.c_str());
+		Instrument::writeSummary(profile_file);
+	}
+	if (!trace_fileName.empty())
+	{
+		std::ofstream trace_file(trace_fileName.c_str());
+		Instrument::writeTrace(trace_file);
+	}
 	return 0;
 }
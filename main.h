@@ -10,6 +10,7 @@
 #include <map>
 #include <set>
 #include <limits>
+#include <climits>
 #include <algorithm>
 
 #endif // __MAIN_H__
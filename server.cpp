@@ -0,0 +1,97 @@
+#include "main.h"
+#include <thread>
+#include "BaseGraph.h"
+#include "Graph.h"
+#include "LineSocket.h"
+#include "QueryServer.h"
+
+void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " <graph_file> [options]\n"
+			  << "  --socket <path>       listen on a Unix-domain socket (default dsc_server.sock)\n"
+			  << "  --port <n>            listen on the loopback TCP port instead\n"
+			  << "  --workers <n>         worker threads answering the requests\n"
+			  << "  --queue <n>           requests waiting for a worker before the connections stop reading\n"
+			  << "  --max-k <n>           largest k of a KSP request\n"
+			  << "  --maxflow-limit <n>   largest graph answering MAXFLOW requests\n"
+			  << "  --weight-unit <km>    integer weight mode\n"
+			  << "  --vertex-order <o>    bfs or rcm storage order\n"
+			  << "  --storage compact     packed graph storage\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+	std::string graph_fileName = argv[1];
+	std::string socket_path = "dsc_server.sock";
+	int port = 0;
+	int worker_num = std::max(1, (int)std::thread::hardware_concurrency());
+	int queue_capacity = 256;
+	int max_k = 1000;
+	int max_flow_limit = 1000;
+	double weight_unit = 0;
+	Graph::VertexOrder vertex_order = Graph::ORDER_FIRST_SEEN;
+	bool is_compact = false;
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "--socket")
+		{
+			socket_path = value;
+		}
+		else if (option == "--port")
+		{
+			port = atoi(value.c_str());
+		}
+		else if (option == "--workers")
+		{
+			worker_num = atoi(value.c_str());
+		}
+		else if (option == "--queue")
+		{
+			queue_capacity = atoi(value.c_str());
+		}
+		else if (option == "--max-k")
+		{
+			max_k = atoi(value.c_str());
+		}
+		else if (option == "--maxflow-limit")
+		{
+			max_flow_limit = atoi(value.c_str());
+		}
+		else if (option == "--weight-unit")
+		{
+			weight_unit = atof(value.c_str());
+		}
+		else if (option == "--vertex-order" && (value == "bfs" || value == "rcm"))
+		{
+			vertex_order = value == "bfs" ? Graph::ORDER_BFS : Graph::ORDER_RCM;
+		}
+		else if (option == "--storage" && value == "compact")
+		{
+			is_compact = true;
+		}
+		else
+		{
+			argc = 0;
+		}
+	}
+	if (argc < 2 || argc % 2 != 0)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	Graph graph(graph_fileName, weight_unit, vertex_order, is_compact);
+	QueryServer server(graph, worker_num, queue_capacity, max_k, max_flow_limit);
+	int listen_fd = port > 0 ? LineSocket::listenTcp(port) : LineSocket::listenUnix(socket_path);
+	std::cerr << "[SERVER] " << graph.getVertexNum() << " vertices, " << graph.getEdgeNum() << " edges, listening on "
+			  << (port > 0 ? "127.0.0.1:" + std::to_string(port) : socket_path) << std::endl;
+	server.serve(listen_fd);
+	return 1;
+}